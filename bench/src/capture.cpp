@@ -0,0 +1,94 @@
+/**
+ * @file capture.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief replay throughput of a capture file through protocal_find_frame_ts
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * A 4 MiB capture of 16 byte frames cut into records of 1..64 bytes is
+ * written once to /tmp, then replayed with rx fifos of different sizes.
+ */
+#ifdef __linux__
+#include "capture_replay.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+const size_t frame_len = 16;
+const size_t capture_bytes = 4 << 20;
+
+extern "C" int match_bench(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if (c != char(0xaa))
+    return -1;
+  return fifo_len(ptr) < frame_len ? 0 : frame_len;
+}
+
+size_t file_sink(void *userdata, const void *data, size_t len) {
+  return write(*static_cast<int *>(userdata), data, len);
+}
+
+std::string make_capture() {
+  static char buf[4096];
+  char path[] = "/tmp/capture_bench_XXXXXX";
+  std::string frame(frame_len, 'x');
+  std::mt19937 rng(1);
+  capture_t cap;
+  size_t pos = 0;
+  int fd = mkstemp(path);
+
+  frame[0] = char(0xaa);
+  capture_init(&cap, buf, sizeof(buf), file_sink, &fd, 1);
+  for (uint32_t time = 0; pos < capture_bytes; time++) {
+    size_t n = rng() % 64 + 1;
+    std::string chunk;
+    for (size_t i = 0; i < n; i++)
+      chunk += frame[(pos + i) % frame_len];
+    capture_write(&cap, 0, capture_rx, time, chunk.data(), n);
+    pos += n;
+  }
+  capture_flush(&cap);
+  close(fd);
+  return path;
+}
+
+void BM_capture_replay(benchmark::State &state) {
+  static std::string path = make_capture();
+  std::string rx_buf(state.range(0), 0);
+  char frame[frame_len];
+  fifo_t rx = {rx_buf.size(), 1, 0, 0, &rx_buf[0]};
+  capture_file_t file;
+  capture_replay_t replay = {};
+#if UART_RX_MARKS
+  uart_rx_mark_t mark_buf[64];
+  fifo_t marks = {64, sizeof(uart_rx_mark_t), 0, 0, mark_buf};
+  replay.marks = &marks;
+#endif
+  replay.fifo = &rx;
+  replay.match = match_bench;
+  replay.frame_buf = frame;
+  replay.frame_size = sizeof(frame);
+
+  if (capture_open(&file, path.c_str())) {
+    state.SkipWithError("capture_open");
+    return;
+  }
+  for (auto _ : state) {
+    file.pos = sizeof(capture_header_t);
+    capture_replay(&file, 0, capture_rx, &replay, NULL, NULL);
+  }
+  capture_close(&file);
+  state.SetBytesProcessed(replay.bytes);
+  state.counters["frames"] = double(replay.frames) / state.iterations();
+  state.counters["stalled"] = double(replay.stalled);
+}
+BENCHMARK(BM_capture_replay)->Arg(256)->Arg(4096)->Arg(65536);
+
+} // namespace
+#endif
@@ -0,0 +1,94 @@
+/**
+ * @file fifo.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief fifo_push/fifo_pop throughput against item size, batch size and
+ * number of producer/consumer pairs
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "fifo_utils.h"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const size_t fifo_items = 1024;
+
+// args: item size, batch size
+void BM_fifo_push_pop(benchmark::State &state) {
+  size_t item = state.range(0), batch = state.range(1);
+  std::vector<char> buf(fifo_items * item), data(batch * item);
+  fifo_t fifo = {fifo_items, item, 0, 0, buf.data()};
+
+  for (auto _ : state) {
+    fifo_push(&fifo, data.data(), batch);
+    fifo_pop(&fifo, data.data(), batch);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+  state.SetBytesProcessed(state.iterations() * batch * item);
+}
+BENCHMARK(BM_fifo_push_pop)->ArgsProduct({{1, 4, 16, 64}, {1, 8, 64}});
+
+// args: batch size, wrapped in place through fifo_reserve/fifo_commit
+void BM_fifo_reserve_commit(benchmark::State &state) {
+  size_t batch = state.range(0);
+  std::vector<char> buf(fifo_items), data(batch);
+  fifo_t fifo = {fifo_items, 1, 0, 0, buf.data()};
+
+  for (auto _ : state) {
+    size_t done = 0;
+    while (done < batch) {
+      void *dst;
+      size_t n = fifo_reserve(&fifo, &dst);
+      n = n < batch - done ? n : batch - done;
+      memcpy(dst, data.data() + done, n);
+      fifo_commit(&fifo, n);
+      done += n;
+    }
+    fifo_pop(&fifo, data.data(), batch);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_fifo_reserve_commit)->Arg(1)->Arg(64)->Arg(512);
+
+// even threads produce, odd threads consume, one fifo per pair
+const int max_pairs = 4;
+fifo_t spsc_fifo[max_pairs];
+char spsc_buf[max_pairs][fifo_items];
+
+void BM_fifo_spsc(benchmark::State &state) {
+  size_t batch = state.range(0);
+  int pair = state.thread_index() / 2;
+  bool producer = !(state.thread_index() & 1);
+  fifo_t *fifo = &spsc_fifo[pair];
+  std::vector<char> data(batch);
+
+  if (producer)
+    *fifo = {fifo_items, 1, 0, 0, spsc_buf[pair]};
+  for (auto _ : state) {
+    if (producer) {
+      while (fifo_capacity(fifo) - fifo_len(fifo) < batch)
+        std::this_thread::yield();
+      fifo_push(fifo, data.data(), batch);
+    } else {
+      while (fifo_len(fifo) < batch)
+        std::this_thread::yield();
+      fifo_pop(fifo, data.data(), batch);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_fifo_spsc)
+    ->Arg(1)
+    ->Arg(64)
+    ->ThreadRange(2, 2 * max_pairs)
+    ->UseRealTime();
+
+} // namespace
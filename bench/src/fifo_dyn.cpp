@@ -0,0 +1,56 @@
+/**
+ * @file fifo_dyn.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief amortized push cost of the growable fifo
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Every iteration starts from a 16 byte fifo and pushes range(0) bytes in
+ * 64 byte batches, so the buffer doubles log2(range(0) / 16) times.
+ * bytes_per_second should stay flat as range(0) grows. BM_fifo_dyn_fixed
+ * pushes into a buffer that is large enough from the start.
+ */
+#ifdef __linux__
+#include "fifo_dyn.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+void BM_fifo_dyn_push(benchmark::State &state) {
+  const size_t total = state.range(0), batch = 64;
+  std::vector<char> data(batch);
+  fifo_dyn_t dyn;
+
+  for (auto _ : state) {
+    fifo_dyn_init(&dyn, 1, 16, size_t(1) << 30, false);
+    for (size_t i = 0; i < total; i += batch)
+      fifo_dyn_push(&dyn, data.data(), batch);
+    benchmark::DoNotOptimize(dyn.fifo.index_end);
+    fifo_dyn_deinit(&dyn);
+  }
+  state.SetBytesProcessed(state.iterations() * total);
+  state.counters["grows"] = dyn.grows;
+}
+BENCHMARK(BM_fifo_dyn_push)->RangeMultiplier(8)->Range(1 << 10, 1 << 25);
+
+void BM_fifo_dyn_fixed(benchmark::State &state) {
+  const size_t total = state.range(0), batch = 64;
+  std::vector<char> data(batch);
+  fifo_dyn_t dyn;
+
+  for (auto _ : state) {
+    fifo_dyn_init(&dyn, 1, total * 2, total * 2, false);
+    for (size_t i = 0; i < total; i += batch)
+      fifo_dyn_push(&dyn, data.data(), batch);
+    benchmark::DoNotOptimize(dyn.fifo.index_end);
+    fifo_dyn_deinit(&dyn);
+  }
+  state.SetBytesProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_fifo_dyn_fixed)->RangeMultiplier(8)->Range(1 << 10, 1 << 25);
+
+} // namespace
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file fifo_spill.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief burst absorption of fifo_spill with a stalled consumer
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * 64 byte items are pushed until the burst size is reached, then drained.
+ * The ring holds 256 KiB, the rest goes through 16 MiB segments in /tmp.
+ */
+#ifdef __linux__
+#include "fifo_spill.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+struct spill_item {
+  char line[64];
+};
+
+// arg: burst in MiB
+void BM_fifo_spill_burst(benchmark::State &state) {
+  const size_t ring = 4096, batch = 64;
+  size_t items = (size_t(state.range(0)) << 20) / sizeof(spill_item);
+  std::vector<spill_item> buf(ring), data(batch);
+  fifo_t fifo = {ring, sizeof(spill_item), 0, 0, buf.data()};
+  fifo_spill_t spill;
+
+  fifo_spill_init(&spill, &fifo, "/tmp", ring - 1, 16 << 20);
+  for (auto _ : state) {
+    for (size_t i = 0; i < items; i += batch) {
+      if (fifo_spill_push(&spill, data.data(), batch) != batch) {
+        state.SkipWithError("fifo_spill_push");
+        break;
+      }
+    }
+    while (fifo_spill_pop(&spill, data.data(), batch))
+      ;
+  }
+  fifo_spill_deinit(&spill);
+  state.SetBytesProcessed(state.iterations() * items * sizeof(spill_item));
+  state.counters["spilled_mib"] =
+      double(spill.spilled * sizeof(spill_item)) / (1 << 20);
+}
+BENCHMARK(BM_fifo_spill_burst)
+    ->Arg(64)
+    ->Arg(512)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file frame_dispatch.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief frame rate of frame_dispatch against worker count
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * One thread allocates 64 byte frames for 64 sessions and posts them, the
+ * workers run a crc over each frame as stand-in for real handling. The
+ * inline case handles frames on the posting thread. Scaling needs as many
+ * cores as workers + 1.
+ */
+#ifdef __linux__
+#include "frame_dispatch.h"
+#include <benchmark/benchmark.h>
+#include <cerrno>
+#include <sched.h>
+#include <vector>
+
+namespace {
+
+const int dispatch_frame = 64;
+const int dispatch_sessions = 64;
+const int dispatch_batch = 4096;
+
+uint32_t handle_frame(const frame_t *frame) {
+  uint32_t crc = 0xffffffff;
+  // a few rounds make handling cost more than dispatching
+  for (int round = 0; round < 4; round++) {
+    for (size_t i = 0; i < frame->len; i++) {
+      crc ^= (unsigned char)frame->data[i];
+      for (int b = 0; b < 8; b++)
+        crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+  }
+  return crc;
+}
+
+extern "C" void on_bench_frame(unsigned, uint32_t, frame_t *frame, void *) {
+  benchmark::DoNotOptimize(handle_frame(frame));
+}
+
+frame_t *bench_frame(frame_pool_t *pool) {
+  frame_t *f;
+  while (!(f = frame_alloc(pool)))
+    sched_yield();
+  f->len = dispatch_frame;
+  return f;
+}
+
+void BM_dispatch_inline(benchmark::State &state) {
+  static frame_t frames[256];
+  static char buf[256 * dispatch_frame];
+  frame_pool_t pool;
+
+  frame_pool_init(&pool, frames, buf, 256, dispatch_frame);
+  for (auto _ : state) {
+    for (int i = 0; i < dispatch_batch; i++) {
+      frame_t *f = bench_frame(&pool);
+      on_bench_frame(0, i % dispatch_sessions, f, nullptr);
+      frame_unref(f);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * dispatch_batch);
+}
+BENCHMARK(BM_dispatch_inline)->UseRealTime();
+
+// arg: workers
+void BM_dispatch_workers(benchmark::State &state) {
+  static frame_t frames[1024];
+  static char buf[1024 * dispatch_frame];
+  unsigned count = state.range(0);
+  std::vector<frame_dispatch_worker_t> workers(count);
+  std::vector<frame_dispatch_item_t> items(count * 64);
+  frame_dispatch_t dispatch;
+  frame_pool_t pool;
+  size_t max_depth = 0;
+
+  frame_pool_init(&pool, frames, buf, 1024, dispatch_frame);
+  if (frame_dispatch_init(&dispatch, workers.data(), count, items.data(), 64,
+                          on_bench_frame, nullptr)) {
+    state.SkipWithError("frame_dispatch_init");
+    return;
+  }
+  for (auto _ : state) {
+    for (int i = 0; i < dispatch_batch; i++) {
+      frame_t *f = bench_frame(&pool);
+      while (frame_dispatch_post(&dispatch, i % dispatch_sessions, f) ==
+             -EAGAIN)
+        sched_yield();
+    }
+    // the batch is done once the pool is whole again
+    while (frame_pool_available(&pool) != 1024)
+      sched_yield();
+  }
+  frame_dispatch_deinit(&dispatch);
+  for (unsigned w = 0; w < count; w++) {
+    frame_dispatch_stats_t st;
+    frame_dispatch_stats(&dispatch, w, &st);
+    max_depth = st.max_depth > max_depth ? st.max_depth : max_depth;
+  }
+  state.SetItemsProcessed(state.iterations() * dispatch_batch);
+  state.counters["max_depth"] = double(max_depth);
+}
+BENCHMARK(BM_dispatch_workers)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+} // namespace
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file pool.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief handing one frame to several consumers, copies against pool frames
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <pool_utils.h>
+#include <protocal_utils.h>
+#include <vector>
+
+namespace {
+
+size_t pool_frame_len;
+
+extern "C" int match_pool_bench(fifo_t *ptr) {
+  return fifo_len(ptr) < pool_frame_len ? 0 : int(pool_frame_len);
+}
+
+// args: frame size, consumers
+void BM_fanout_copy(benchmark::State &state) {
+  size_t frame = state.range(0), consumers = state.range(1);
+  char buf[1024], out[256];
+  std::vector<std::vector<char>> copies(consumers, std::vector<char>(frame));
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+
+  pool_frame_len = frame;
+  for (auto _ : state) {
+    fifo_push(&fifo, out, frame);
+    int len = protocal_find_frame(&fifo, match_pool_bench, out, sizeof(out));
+    for (auto &c : copies)
+      memcpy(c.data(), out, len);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_fanout_copy)->ArgsProduct({{64, 256}, {1, 2, 4}});
+
+void BM_fanout_pool(benchmark::State &state) {
+  size_t frame = state.range(0), consumers = state.range(1);
+  char buf[1024], in[256] = {};
+  static frame_t frames[16];
+  static char pool_buf[16 * 256];
+  std::vector<frame_t *> held(consumers);
+  frame_pool_t pool;
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+
+  pool_frame_len = frame;
+  frame_pool_init(&pool, frames, pool_buf, 16, 256);
+  for (auto _ : state) {
+    fifo_push(&fifo, in, frame);
+    frame_t *f = protocal_find_frame_pool(&fifo, match_pool_bench, &pool);
+    for (auto &h : held)
+      h = frame_ref(f);
+    frame_unref(f);
+    benchmark::ClobberMemory();
+    for (auto h : held)
+      frame_unref(h);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_fanout_pool)->ArgsProduct({{64, 256}, {1, 2, 4}});
+
+} // namespace
@@ -0,0 +1,147 @@
+/**
+ * @file protocal.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief protocal_find_frame throughput against frame size and noise ratio
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * The stream is 0xA5, length, payload frames with random non 0xA5 bytes
+ * between them. Noise is dropped one byte per matcher call, which is the
+ * worst case for the matcher contract.
+ *
+ * BM_protocal_enc encodes frames straight into the tx fifo,
+ * BM_protocal_enc_copy encodes into a stack buffer first and pushes the
+ * result, which is what callers did before the streaming encoders.
+ */
+#include "protocal_utils.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+const size_t stream_bytes = 64 << 10;
+
+extern "C" int match_len_byte(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if ((unsigned char)c != 0xA5)
+    return -1;
+  if (fifo_len(ptr) < 2)
+    return 0;
+  fifo_peek(ptr, 1, &c);
+  return fifo_len(ptr) < (unsigned char)c ? 0 : (unsigned char)c;
+}
+
+std::vector<char> make_stream(size_t frame, int noise_percent,
+                              size_t *frames) {
+  std::vector<char> out;
+  std::mt19937 rng(1);
+  size_t acc = 0;
+  *frames = 0;
+  while (out.size() < stream_bytes) {
+    // noise bytes so that noise_percent of the stream is noise
+    acc += frame * noise_percent;
+    size_t noise = acc / (100 - noise_percent);
+    acc %= 100 - noise_percent;
+    for (size_t i = 0; i < noise; i++)
+      out.push_back(char(rng() % 0xA5));
+    out.push_back(char(0xA5));
+    out.push_back(char(frame));
+    for (size_t i = 2; i < frame; i++)
+      out.push_back(char(i));
+    ++*frames;
+  }
+  return out;
+}
+
+// args: frame size, noise percent
+void BM_protocal_find_frame(benchmark::State &state) {
+  size_t frame = state.range(0), frames, found = 0;
+  std::vector<char> stream = make_stream(frame, state.range(1), &frames);
+  char buf[1024], out[256];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+
+  for (auto _ : state) {
+    size_t pos = 0;
+    found = 0;
+    while (pos < stream.size() || fifo_len(&fifo)) {
+      size_t n = fifo_capacity(&fifo) - fifo_len(&fifo);
+      n = n < stream.size() - pos ? n : stream.size() - pos;
+      fifo_push(&fifo, stream.data() + pos, n);
+      pos += n;
+      while (fifo_len(&fifo)) {
+        size_t len = fifo_len(&fifo);
+        if (protocal_find_frame(&fifo, match_len_byte, out, sizeof(out)))
+          found++;
+        else if (fifo_len(&fifo) == len)
+          break;
+      }
+      if (pos == stream.size() && fifo_len(&fifo))
+        break;
+    }
+    fifo.index_start = fifo.index_end = 0;
+  }
+  if (found != frames)
+    state.SkipWithError("frames lost");
+  state.SetBytesProcessed(state.iterations() * stream.size());
+  state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_protocal_find_frame)
+    ->ArgsProduct({{8, 64, 255}, {0, 10, 50}});
+
+std::vector<char> make_payload(size_t len) {
+  std::vector<char> out(len);
+  std::mt19937 rng(2);
+  for (auto &c : out)
+    c = char(rng());
+  return out;
+}
+
+// args: protocal_enc_type_t, payload size
+void BM_protocal_enc(benchmark::State &state) {
+  auto type = protocal_enc_type_t(state.range(0));
+  std::vector<char> payload = make_payload(state.range(1));
+  char buf[1024];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+  protocal_enc_t enc;
+
+  for (auto _ : state) {
+    protocal_enc_begin(&enc, &fifo, type, payload.size());
+    protocal_enc_write(&enc, payload.data(), payload.size());
+    protocal_enc_end(&enc);
+    // the tx isr drains it
+    fifo.index_start = fifo.index_end;
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_protocal_enc)
+    ->ArgsProduct({{protocal_enc_cobs, protocal_enc_slip,
+                    protocal_enc_len_crc},
+                   {16, 255}});
+
+void BM_protocal_enc_copy(benchmark::State &state) {
+  auto type = protocal_enc_type_t(state.range(0));
+  std::vector<char> payload = make_payload(state.range(1));
+  char buf[1024], frame[1024];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+  fifo_t stack = {sizeof(frame), 1, 0, 0, frame};
+  protocal_enc_t enc;
+
+  for (auto _ : state) {
+    stack.index_start = stack.index_end = 0;
+    protocal_enc_begin(&enc, &stack, type, payload.size());
+    protocal_enc_write(&enc, payload.data(), payload.size());
+    fifo_push(&fifo, frame, protocal_enc_end(&enc));
+    fifo.index_start = fifo.index_end;
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_protocal_enc_copy)
+    ->ArgsProduct({{protocal_enc_cobs, protocal_enc_slip,
+                    protocal_enc_len_crc},
+                   {16, 255}});
+
+} // namespace
@@ -0,0 +1,95 @@
+/**
+ * @file uart_isr.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief per byte cost of the uart_t isr handlers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Built into bench against utils_c and, with USE_FIFO_INLINE, into
+ * bench_inline against utils_c_inline. Compare the two runs to see what
+ * the out of line fifo calls cost, the label tells which one ran.
+ */
+#include "uart_utils.h"
+#include <benchmark/benchmark.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+const int burst = 64;
+
+inline uint64_t isr_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+char isr_sink;
+char *isr_rx_slot;
+
+extern "C" {
+static void isr_rx_async(char *ch, void *) { isr_rx_slot = ch; }
+static void isr_rx_async_abort(void *) {}
+static void isr_tx_async(const char *ch, void *) {
+  benchmark::DoNotOptimize(isr_sink = *ch);
+}
+static void isr_tx_async_abort(void *) {}
+}
+
+const uart_io_t isr_io = {isr_rx_async, isr_rx_async_abort, isr_tx_async,
+                          isr_tx_async_abort};
+
+void isr_report(benchmark::State &state, uint64_t total) {
+  state.SetLabel(FIFO_UTILS_INLINE ? "fifo inline" : "fifo call");
+  state.SetItemsProcessed(state.iterations() * burst);
+  state.counters["cycles_per_byte"] =
+      double(total) / (double(state.iterations()) * burst);
+}
+
+void BM_uart_isr_tx(benchmark::State &state) {
+  char rx_buf[256], tx_buf[256], msg[burst] = {};
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uint64_t total = 0;
+
+  uart_init(&inst, &isr_io, nullptr, &rx, &tx);
+  for (auto _ : state) {
+    uart_write(&inst, msg, burst);
+    uint64_t t0 = isr_cycles();
+    while (uart_status(&inst) == uart_status_tx)
+      uart_isr_handle_tx(&inst);
+    total += isr_cycles() - t0;
+  }
+  isr_report(state, total);
+}
+BENCHMARK(BM_uart_isr_tx);
+
+void BM_uart_isr_rx(benchmark::State &state) {
+  char rx_buf[256], tx_buf[256], buf[burst];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uint64_t total = 0;
+
+  uart_init(&inst, &isr_io, nullptr, &rx, &tx);
+  uart_enable_rx(&inst);
+  for (auto _ : state) {
+    uint64_t t0 = isr_cycles();
+    for (int i = 0; i < burst; i++) {
+      *isr_rx_slot = char(i);
+      uart_isr_handle_rx(&inst);
+    }
+    total += isr_cycles() - t0;
+    uart_read(&inst, buf, burst);
+  }
+  isr_report(state, total);
+}
+BENCHMARK(BM_uart_isr_rx);
+
+} // namespace
@@ -0,0 +1,122 @@
+/**
+ * @file uart_loop.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief aggregate frame rate of uart_loop against port count, pty backed
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+
+#include "pty_pair.h"
+#include "uart_loop.h"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int frame_size = 16;
+const int frames_per_round = 32;
+
+extern "C" int match_fixed(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if ((unsigned char)c != 0xA5)
+    return -1;
+  return fifo_len(ptr) < frame_size ? 0 : frame_size;
+}
+
+struct bench_port {
+  pty_pair pty;
+  uart_loop_port_t port;
+  fifo_t rx, tx;
+  char rx_buf[1024], tx_buf[64], frame[frame_size];
+};
+
+struct bench_ctx {
+  std::vector<uart_loop_t> loops;
+  std::vector<std::unique_ptr<bench_port>> ports;
+  std::atomic<long> frames{0};
+
+  static void on_frame(uart_loop_port_t *, const char *, size_t,
+                       void *userdata) {
+    reinterpret_cast<bench_ctx *>(userdata)->frames.fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  bool setup(int port_num, int worker_num) {
+    loops.resize(worker_num);
+    for (auto &loop : loops)
+      if (uart_loop_init(&loop))
+        return false;
+    for (int i = 0; i < port_num; i++) {
+      auto p = std::unique_ptr<bench_port>(new bench_port);
+      if (!p->pty.ok())
+        return false;
+      p->rx = {sizeof(p->rx_buf), 1, 0, 0, p->rx_buf};
+      p->tx = {sizeof(p->tx_buf), 1, 0, 0, p->tx_buf};
+      // shard ports over the workers
+      if (uart_loop_add(&loops[i % worker_num], &p->port, p->pty.slave, &p->rx,
+                        &p->tx))
+        return false;
+      uart_loop_set_matcher(&p->port, match_fixed, p->frame, frame_size,
+                            on_frame, this);
+      uart_enable_rx(&p->port.uart);
+      ports.push_back(std::move(p));
+    }
+    return true;
+  }
+
+  ~bench_ctx() {
+    for (auto &loop : loops)
+      uart_loop_deinit(&loop);
+  }
+};
+
+void BM_uart_loop_frames(benchmark::State &state) {
+  const int port_num = state.range(0);
+  const int worker_num = state.range(1);
+  bench_ctx ctx;
+  std::string wire;
+
+  for (int i = 0; i < frames_per_round; i++) {
+    wire += '\xA5';
+    wire.append(frame_size - 1, char(i));
+  }
+  if (!ctx.setup(port_num, worker_num)) {
+    state.SkipWithError("pty setup failed");
+    return;
+  }
+  if (worker_num > 1)
+    for (auto &loop : ctx.loops)
+      uart_loop_start(&loop);
+
+  long expect = 0;
+  for (auto _ : state) {
+    for (auto &p : ctx.ports)
+      if (write(p->pty.master, wire.data(), wire.size()) !=
+          (ssize_t)wire.size())
+        state.SkipWithError("pty write failed");
+    expect += (long)port_num * frames_per_round;
+    while (ctx.frames.load(std::memory_order_relaxed) < expect)
+      if (worker_num == 1)
+        uart_loop_run_once(&ctx.loops[0], 1000);
+  }
+  state.SetItemsProcessed(state.iterations() * port_num * frames_per_round);
+  state.SetBytesProcessed(state.items_processed() * frame_size);
+}
+
+} // namespace
+
+BENCHMARK(BM_uart_loop_frames)
+    ->ArgNames({"ports", "workers"})
+    ->ArgsProduct({{1, 8, 32, 128, 256}, {1}})
+    ->ArgsProduct({{32, 256}, {2, 4}})
+    ->UseRealTime();
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * @file uart_mp.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief frame rate of concurrent writers, uart_mp against a mutex
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+
+#include "uart_mp.h"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int frame_size = 16;
+const int frames_per_writer = 1024;
+
+extern "C" {
+static void bench_rx_async(char *, void *) {}
+static void bench_rx_async_abort(void *) {}
+static void bench_tx_async(const char *, void *) {}
+static void bench_tx_async_abort(void *) {}
+}
+
+const uart_io_t bench_io = {bench_rx_async, bench_rx_async_abort,
+                            bench_tx_async, bench_tx_async_abort};
+
+// backend thread standing in for the tx isr, drains as fast as it can
+struct bench_uart {
+  fifo_t rx, tx;
+  char rx_buf[16], tx_buf[1024];
+  uart_t uart;
+  uart_mp_t mp;
+  std::mutex lock;
+  std::atomic<bool> kick{false}, stop{false};
+  std::thread backend;
+
+  static void on_kick(uart_mp_t *mp) {
+    static_cast<bench_uart *>(mp->userdata)
+        ->kick.store(true, std::memory_order_release);
+  }
+
+  explicit bench_uart(bool mp_mode) {
+    rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+    tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+    uart_init(&uart, &bench_io, this, &rx, &tx);
+    uart_mp_init(&mp, &uart, on_kick, this);
+    backend = std::thread([this, mp_mode] {
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (mp_mode) {
+          if (kick.exchange(false, std::memory_order_acquire))
+            uart_mp_service(&mp);
+          while (uart_status(&uart) == uart_status_tx)
+            uart_isr_handle_tx(&uart);
+        } else {
+          std::lock_guard<std::mutex> guard(lock);
+          while (uart_status(&uart) == uart_status_tx)
+            uart_isr_handle_tx(&uart);
+        }
+        sched_yield();
+      }
+    });
+  }
+
+  ~bench_uart() {
+    stop = true;
+    backend.join();
+  }
+};
+
+template <bool mp_mode> void BM_uart_writers(benchmark::State &state) {
+  const int writer_num = state.range(0);
+  bench_uart u(mp_mode);
+  char frame[frame_size] = {};
+
+  for (auto _ : state) {
+    std::vector<std::thread> writers;
+    for (int w = 0; w < writer_num; w++) {
+      writers.emplace_back([&u, &frame] {
+        for (int i = 0; i < frames_per_writer; i++) {
+          if (mp_mode) {
+            while (!uart_mp_write(&u.mp, frame, frame_size))
+              sched_yield();
+            continue;
+          }
+          for (;;) {
+            std::lock_guard<std::mutex> guard(u.lock);
+            // keep frames whole like uart_mp does
+            if (fifo_capacity(&u.tx) - fifo_len(&u.tx) >= frame_size) {
+              uart_write(&u.uart, frame, frame_size);
+              break;
+            }
+            sched_yield();
+          }
+        }
+      });
+    }
+    for (auto &t : writers)
+      t.join();
+  }
+  state.SetItemsProcessed(state.iterations() * writer_num * frames_per_writer);
+  state.SetBytesProcessed(state.items_processed() * frame_size);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_uart_writers, true)
+    ->Name("BM_uart_mp_write")
+    ->ArgName("writers")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_uart_writers, false)
+    ->Name("BM_uart_mutex_write")
+    ->ArgName("writers")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+#endif
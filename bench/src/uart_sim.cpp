@@ -0,0 +1,80 @@
+/**
+ * @file uart_sim.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief isr cost per byte and worst case latency on the simulated device
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+
+#include "uart_sim.h"
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const size_t burst = 4096;
+
+// rx: bytes arrive back to back, consumer drains the fifo every 64 bytes
+void BM_uart_sim_rx(benchmark::State &state) {
+  uart_sim::config cfg;
+  cfg.baud = state.range(0);
+  cfg.irq_latency_ns = state.range(1);
+  cfg.measure_cpu = true;
+  static char rx_buf[256], tx_buf[256], wire[burst], tmp[256];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(cfg);
+
+  sim.attach(&inst, &rx, &tx);
+  uart_enable_rx(&inst);
+  for (auto _ : state) {
+    uint64_t cpu = sim.stat().isr_cpu_ns;
+    sim.feed(wire, burst);
+    for (size_t i = 0; i < burst; i += 64) {
+      sim.run_until(sim.now() + 64 * sim.byte_ns());
+      uart_read(&inst, tmp, sizeof(tmp));
+    }
+    sim.run();
+    uart_read(&inst, tmp, sizeof(tmp));
+    state.SetIterationTime((sim.stat().isr_cpu_ns - cpu) * 1e-9);
+  }
+  state.SetItemsProcessed(sim.stat().rx_isr);
+  state.counters["max_latency_ns"] = sim.max_rx_latency();
+  state.counters["overrun"] = benchmark::Counter(
+      sim.stat().rx_overrun, benchmark::Counter::kAvgIterations);
+}
+
+void BM_uart_sim_tx(benchmark::State &state) {
+  uart_sim::config cfg;
+  cfg.baud = state.range(0);
+  cfg.irq_latency_ns = state.range(1);
+  cfg.measure_cpu = true;
+  static char rx_buf[256], tx_buf[256], msg[255];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(cfg);
+
+  sim.attach(&inst, &rx, &tx);
+  for (auto _ : state) {
+    uint64_t cpu = sim.stat().isr_cpu_ns;
+    uart_write(&inst, msg, sizeof(msg));
+    sim.run();
+    state.SetIterationTime((sim.stat().isr_cpu_ns - cpu) * 1e-9);
+  }
+  state.SetItemsProcessed(sim.stat().tx_wire);
+}
+
+} // namespace
+
+BENCHMARK(BM_uart_sim_rx)
+    ->ArgNames({"baud", "irq_ns"})
+    ->ArgsProduct({{115200, 921600, 4000000}, {500, 5000}})
+    ->UseManualTime();
+BENCHMARK(BM_uart_sim_tx)
+    ->ArgNames({"baud", "irq_ns"})
+    ->Args({115200, 500})
+    ->UseManualTime();
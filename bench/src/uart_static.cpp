@@ -0,0 +1,136 @@
+/**
+ * @file uart_static.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief isr path cost of utils::Uart against uart_t with uart_io_t
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Both sides drive a do-nothing backend, so the numbers are the state
+ * machine plus the fifo. cycles_per_byte is read from the tsc on x86.
+ */
+#include "uart_static.h"
+#include <benchmark/benchmark.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+const int burst = 64;
+
+inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+char sink;
+char *rx_slot;
+
+struct bench_io {
+  void rx_async(char *ch) { rx_slot = ch; }
+  void rx_async_abort() {}
+  void tx_async(const char *ch) { benchmark::DoNotOptimize(sink = *ch); }
+  void tx_async_abort() {}
+};
+
+extern "C" {
+static void c_rx_async(char *ch, void *) { rx_slot = ch; }
+static void c_rx_async_abort(void *) {}
+static void c_tx_async(const char *ch, void *) {
+  benchmark::DoNotOptimize(sink = *ch);
+}
+static void c_tx_async_abort(void *) {}
+}
+
+const uart_io_t c_io = {c_rx_async, c_rx_async_abort, c_tx_async,
+                        c_tx_async_abort};
+
+void report(benchmark::State &state, uint64_t total) {
+  state.SetItemsProcessed(state.iterations() * burst);
+  state.counters["cycles_per_byte"] =
+      double(total) / (double(state.iterations()) * burst);
+}
+
+void BM_uart_c_tx(benchmark::State &state) {
+  char rx_buf[256], tx_buf[256], msg[burst] = {};
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uint64_t total = 0;
+
+  uart_init(&inst, &c_io, nullptr, &rx, &tx);
+  for (auto _ : state) {
+    uint64_t t0 = cycles();
+    uart_write(&inst, msg, burst);
+    while (uart_status(&inst) == uart_status_tx)
+      uart_isr_handle_tx(&inst);
+    total += cycles() - t0;
+  }
+  report(state, total);
+}
+
+void BM_uart_static_tx(benchmark::State &state) {
+  utils::Uart<bench_io, utils::StaticFifo<256>, utils::StaticFifo<256>> uart;
+  char msg[burst] = {};
+  uint64_t total = 0;
+
+  for (auto _ : state) {
+    uint64_t t0 = cycles();
+    uart.write(msg, burst);
+    while (uart.status() == uart_status_tx)
+      uart.isr_tx();
+    total += cycles() - t0;
+  }
+  report(state, total);
+}
+
+void BM_uart_c_rx(benchmark::State &state) {
+  char rx_buf[256], tx_buf[256], buf[burst];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uint64_t total = 0;
+
+  uart_init(&inst, &c_io, nullptr, &rx, &tx);
+  uart_enable_rx(&inst);
+  for (auto _ : state) {
+    uint64_t t0 = cycles();
+    for (int i = 0; i < burst; i++) {
+      *rx_slot = char(i);
+      uart_isr_handle_rx(&inst);
+    }
+    uart_read(&inst, buf, burst);
+    total += cycles() - t0;
+  }
+  report(state, total);
+}
+
+void BM_uart_static_rx(benchmark::State &state) {
+  utils::Uart<bench_io, utils::StaticFifo<256>, utils::StaticFifo<256>> uart;
+  char buf[burst];
+  uint64_t total = 0;
+
+  uart.enable_rx();
+  for (auto _ : state) {
+    uint64_t t0 = cycles();
+    for (int i = 0; i < burst; i++) {
+      *rx_slot = char(i);
+      uart.isr_rx();
+    }
+    uart.read(buf, burst);
+    total += cycles() - t0;
+  }
+  report(state, total);
+}
+
+} // namespace
+
+BENCHMARK(BM_uart_c_tx);
+BENCHMARK(BM_uart_static_tx);
+BENCHMARK(BM_uart_c_rx);
+BENCHMARK(BM_uart_static_rx);
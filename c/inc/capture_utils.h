@@ -0,0 +1,139 @@
+/**
+ * @file capture_utils.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief append only binary capture of rx/tx byte streams
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * A capture is a capture_header_t followed by records. Every record is a
+ * capture_record_t followed by len payload bytes, all little endian and
+ * unpadded. Consecutive bytes of the same channel and direction that are at
+ * most merge_ticks apart share one record, so a burst costs 8 bytes of
+ * overhead, not 8 per byte. The record time is the one of its first byte.
+ *
+ * Records keep the low 32 bits of the tick. Whenever the high bits differ
+ * from the ones last written, a capture_time record carrying them comes
+ * first, so a 64-bit host tick is unwrapped exactly and a 32-bit target
+ * tick never pays for it.
+ *
+ * The writer stages records in a caller buffer and hands full buffers to a
+ * sink (file, flash, socket). It is not reentrant: one context writes, use
+ * one writer per isr or call capture_write under a lock. The c/linux replay
+ * engine (capture_replay.h) reads captures back.
+ *
+ * @code
+ *
+ * static char buf[4096];
+ * static capture_t cap;
+ *
+ * capture_init(&cap, buf, sizeof(buf), file_sink, fp, 1);
+ * uart_set_capture(&uart, &cap, 0);
+ * ...
+ * capture_flush(&cap);
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "clock_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAPTURE_MAGIC 0x50414355 // "UCAP"
+#define CAPTURE_VERSION 2 // 2 added capture_time records
+
+typedef enum {
+  capture_rx = 0,
+  capture_tx = 1,
+  capture_time = 2, // payload: uint32_t high bits of the following times
+} capture_dir_t;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size; // sizeof(capture_header_t), records start here
+  uint32_t tick_ns;     // length of one tick in ns, 0 if unknown
+  uint32_t reserved;
+} capture_header_t;
+
+typedef struct {
+  uint32_t time; // low 32 bits of the tick of the first byte
+  uint16_t len;  // payload bytes following the record
+  uint8_t dir;   // capture_dir_t
+  uint8_t chan;  // user channel, e.g. port number
+} capture_record_t;
+
+/**
+ * @brief consume staged capture bytes
+ *
+ * @return size_t bytes taken, less than len counts as dropped
+ */
+typedef size_t (*capture_sink_fn_t)(void *userdata, const void *data,
+                                    size_t len);
+
+typedef struct {
+  capture_sink_fn_t sink;
+  void *userdata;
+  char *buf;
+  size_t size, used;
+  size_t rec;  // offset of the open record in buf
+  bool open;   // the record at rec may still grow
+  utils_tick_t last_time;
+  utils_tick_t merge_ticks;
+  uint32_t dropped; // bytes the sink refused
+  uint32_t time_hi; // high tick bits last written
+  bool time_lost;   // the sink dropped them, write them again
+} capture_t;
+
+/**
+ * @brief initialize writer and stage the capture header
+ *
+ * @param cap
+ * @param buf staging buffer, > sizeof(capture_header_t) +
+ * sizeof(capture_record_t)
+ * @param size
+ * @param sink
+ * @param userdata
+ * @param tick_ns length of one utils_tick_t in ns, stored in the header
+ */
+void capture_init(capture_t *cap, char *buf, size_t size,
+                  capture_sink_fn_t sink, void *userdata, uint32_t tick_ns);
+
+/**
+ * @brief set how far apart two bytes of a record may be, default 0
+ *
+ * @param cap
+ * @param ticks
+ */
+void capture_set_merge(capture_t *cap, utils_tick_t ticks);
+
+/**
+ * @brief append bytes
+ *
+ * @param cap
+ * @param chan
+ * @param dir
+ * @param time arrival/departure tick of data[0]
+ * @param data
+ * @param len
+ */
+void capture_write(capture_t *cap, uint8_t chan, capture_dir_t dir,
+                   utils_tick_t time, const void *data, size_t len);
+
+/**
+ * @brief hand staged bytes to the sink, the open record is closed
+ *
+ * @param cap
+ */
+void capture_flush(capture_t *cap);
+
+#ifdef __cplusplus
+}
+#endif
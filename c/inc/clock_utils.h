@@ -0,0 +1,47 @@
+/**
+ * @file clock_utils.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief monotonic tick source shared by stats, trace and timestamps
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef UTILS_TICK_TYPE
+#if defined(__unix__) || defined(__APPLE__)
+// the host clock counts ns, 32 bit would wrap after 4.29 s
+#define UTILS_TICK_TYPE uint64_t
+#else
+#define UTILS_TICK_TYPE uint32_t
+#endif
+#endif
+
+/**
+ * @brief monotonic tick, wraps around, compare with differences only
+ */
+typedef UTILS_TICK_TYPE utils_tick_t;
+
+#define UTILS_TICK_MAX ((utils_tick_t)-1)
+
+/**
+ * @brief read current tick
+ *
+ * @note weak symbol. The default counts nanoseconds on hosts and returns 0
+ * elsewhere, override it with a cheap free running counter (e.g. DWT
+ * CYCCNT or a timer) on targets.
+ * @return utils_tick_t
+ */
+utils_tick_t utils_clock_now(void);
+
+#ifdef __cplusplus
+}
+#endif
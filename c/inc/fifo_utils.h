@@ -7,12 +7,25 @@
  *
  * Copyright 2022 savent_gate
  *
+ * Define FIFO_UTILS_INLINE=1 for every translation unit (cmake
+ * USE_FIFO_INLINE builds utils_c_inline that way) to get the functions
+ * below as static inline definitions instead of calls into fifo_utils.c.
  */
 #pragma once
 
 #include <stdbool.h>
 #include <stddef.h>
 
+#ifndef FIFO_UTILS_INLINE
+#define FIFO_UTILS_INLINE 0
+#endif
+
+#if FIFO_UTILS_INLINE
+#define FIFO_API static inline
+#else
+#define FIFO_API
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -56,7 +69,7 @@ typedef struct {
  * @param ptr
  * @return size_t
  */
-size_t fifo_len(fifo_t *ptr);
+FIFO_API size_t fifo_len(fifo_t *ptr);
 
 /**
  * @brief return fifo's maxium item number
@@ -64,7 +77,7 @@ size_t fifo_len(fifo_t *ptr);
  * @param ptr
  * @return size_t
  */
-size_t fifo_capacity(fifo_t *ptr);
+FIFO_API size_t fifo_capacity(fifo_t *ptr);
 
 /**
  * @brief check fifo is full
@@ -73,7 +86,7 @@ size_t fifo_capacity(fifo_t *ptr);
  * @return true full
  * @return false  not full
  */
-bool fifo_full(fifo_t *ptr);
+FIFO_API bool fifo_full(fifo_t *ptr);
 
 /**
  * @brief push item into fifo
@@ -82,7 +95,7 @@ bool fifo_full(fifo_t *ptr);
  * @param[in] data
  * @param num
  */
-void fifo_push(fifo_t *ptr, const void *data, size_t num);
+FIFO_API void fifo_push(fifo_t *ptr, const void *data, size_t num);
 
 /**
  * @brief pop item from fifo
@@ -91,7 +104,26 @@ void fifo_push(fifo_t *ptr, const void *data, size_t num);
  * @param[out] data
  * @param num
  */
-void fifo_pop(fifo_t *ptr, void *data, size_t num);
+FIFO_API void fifo_pop(fifo_t *ptr, void *data, size_t num);
+
+/**
+ * @brief get free space at fifo's tail to write items in place
+ *
+ * @note only the part before the buffer wraps is returned, reserve again
+ * after fifo_commit to get the rest
+ * @param ptr
+ * @param[out] data first free item
+ * @return size_t number of contiguous free items at *data
+ */
+FIFO_API size_t fifo_reserve(fifo_t *ptr, void **data);
+
+/**
+ * @brief publish items written into reserved space
+ *
+ * @param ptr
+ * @param num items to publish, no more than fifo_reserve returned
+ */
+FIFO_API void fifo_commit(fifo_t *ptr, size_t num);
 
 /**
  * @brief peek fifo's data dont pop out
@@ -100,8 +132,12 @@ void fifo_pop(fifo_t *ptr, void *data, size_t num);
  * @param index 0~fifo_len-1
  * @param[out] data
  */
-void fifo_peek(fifo_t *ptr, int index, void *data);
+FIFO_API void fifo_peek(fifo_t *ptr, int index, void *data);
 
 #ifdef __cplusplus
 }
 #endif
+
+#if FIFO_UTILS_INLINE
+#include "fifo_utils_inline.h"
+#endif
@@ -0,0 +1,146 @@
+/**
+ * @file fifo_utils_inline.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief fifo core definitions
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Included once by fifo_utils.c with FIFO_API empty, which gives the
+ * regular out of line functions, or by fifo_utils.h in every translation
+ * unit when FIFO_UTILS_INLINE is set, which makes them static inline so the
+ * per byte calls of the uart isr handlers compile down to a few loads and
+ * stores without LTO. Do not include it directly.
+ */
+#pragma once
+
+#include "fifo_utils.h"
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline bool _fifo_is_aligned_len(const fifo_t *ptr) {
+  size_t fifo_len = ptr->fifo_len;
+  return fifo_len && !(fifo_len & (fifo_len - 1));
+}
+
+// indexes are shared by a producer and a consumer (isr/thread), publish
+// them after the items and load them before touching the items
+static inline size_t _fifo_load_index(const size_t *index) {
+  return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static inline void _fifo_store_index(size_t *index, size_t value) {
+  __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+static inline size_t _fifo_wrap(size_t i, size_t arr_len) {
+  return i & (arr_len - 1);
+}
+
+static inline void *_fifo_pointer(const void *ptr, size_t index,
+                                  size_t item_type_size) {
+  char *p = (char *)ptr;
+  return p + index * item_type_size;
+}
+
+// fifo_len without the argument checks, for use after they passed
+static inline size_t _fifo_count(fifo_t *ptr) {
+  return _fifo_wrap(_fifo_load_index(&ptr->index_end) -
+                        _fifo_load_index(&ptr->index_start),
+                    ptr->fifo_len);
+}
+
+static inline void _fifo_copy(void *dst, const void *src, size_t type_size) {
+  // let the compiler see the common byte fifo as a plain store
+  if (type_size == 1)
+    *(char *)dst = *(const char *)src;
+  else
+    memcpy(dst, src, type_size);
+}
+
+FIFO_API size_t fifo_capacity(fifo_t *ptr) {
+  assert(ptr);
+  assert(_fifo_is_aligned_len(ptr));
+  return ptr->fifo_len - 1;
+}
+
+FIFO_API size_t fifo_len(fifo_t *ptr) {
+  assert(ptr);
+  assert(_fifo_is_aligned_len(ptr));
+  return _fifo_count(ptr);
+}
+
+FIFO_API bool fifo_full(fifo_t *ptr) {
+  assert(ptr);
+  assert(_fifo_is_aligned_len(ptr));
+  return _fifo_count(ptr) == ptr->fifo_len - 1;
+}
+
+FIFO_API void fifo_push(fifo_t *ptr, const void *data, size_t num) {
+  assert(ptr);
+  assert(data);
+  assert(_fifo_is_aligned_len(ptr));
+  assert(_fifo_count(ptr) + num <= ptr->fifo_len - 1);
+  size_t index = ptr->index_end;
+  size_t fifo_len = ptr->fifo_len;
+  size_t type_size = ptr->type_len;
+  char *buffer = (char *)ptr->buffer;
+  for (size_t i = 0; i < num; i++) {
+    _fifo_copy(_fifo_pointer(buffer, index, type_size),
+               _fifo_pointer(data, i, type_size), type_size);
+    index = _fifo_wrap(index + 1, fifo_len);
+  }
+  _fifo_store_index(&ptr->index_end, index);
+}
+
+FIFO_API size_t fifo_reserve(fifo_t *ptr, void **data) {
+  assert(ptr);
+  assert(data);
+  assert(_fifo_is_aligned_len(ptr));
+  size_t space = ptr->fifo_len - 1 - _fifo_count(ptr);
+  size_t tail = ptr->fifo_len - ptr->index_end;
+  *data = _fifo_pointer(ptr->buffer, ptr->index_end, ptr->type_len);
+  return space < tail ? space : tail;
+}
+
+FIFO_API void fifo_commit(fifo_t *ptr, size_t num) {
+  assert(ptr);
+  assert(_fifo_is_aligned_len(ptr));
+  assert(_fifo_count(ptr) + num <= ptr->fifo_len - 1);
+  _fifo_store_index(&ptr->index_end,
+                    _fifo_wrap(ptr->index_end + num, ptr->fifo_len));
+}
+
+static inline size_t _fifo_peek(fifo_t *ptr, int offset, void *data,
+                                size_t num) {
+  assert(ptr);
+  assert(_fifo_is_aligned_len(ptr));
+  assert(_fifo_count(ptr) >= num);
+  size_t fifo_len = ptr->fifo_len;
+  size_t index = _fifo_wrap(ptr->index_start + offset, fifo_len);
+  size_t type_size = ptr->type_len;
+  char *buffer = (char *)ptr->buffer;
+  for (size_t i = 0; i < num; i++) {
+    _fifo_copy(_fifo_pointer(data, i, type_size),
+               _fifo_pointer(buffer, index, type_size), type_size);
+    index = _fifo_wrap(index + 1, fifo_len);
+  }
+  return index;
+}
+
+FIFO_API void fifo_pop(fifo_t *ptr, void *data, size_t num) {
+  _fifo_store_index(&ptr->index_start, _fifo_peek(ptr, 0, data, num));
+}
+
+FIFO_API void fifo_peek(fifo_t *ptr, int index, void *data) {
+  _fifo_peek(ptr, index, data, 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
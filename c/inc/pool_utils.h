@@ -0,0 +1,128 @@
+/**
+ * @file pool_utils.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief fixed size, lock free pool of reference counted frame buffers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * The free list is a Treiber stack whose head packs a 16 bit slot index
+ * with a 16 bit tag bumped on every change, so a stale head never wins a
+ * compare and swap (ABA). Everything is 32 bit atomics, allocation and
+ * release work from any thread or isr. A frame starts with one reference,
+ * every consumer it is handed to takes one more with frame_ref and drops
+ * it with frame_unref, the last drop puts it back on the free list.
+ *
+ * @code
+ *
+ * FRAME_POOL_DEFINE(rx, 16, 64);
+ *
+ * frame_t *f = protocal_find_frame_pool(&rx_fifo, match, FRAME_POOL_PTR(rx));
+ * if (f) {
+ *   logger_post(frame_ref(f));
+ *   router_post(frame_ref(f));
+ *   frame_unref(f);
+ * }
+ *
+ * @endcode
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_POOL_MAX 0xfffe // index 0xffff ends the free list
+
+typedef struct frame_pool frame_pool_t;
+
+typedef struct frame_s {
+  char *data;
+  size_t len;          // bytes used in data, set by the producer
+  frame_pool_t *pool;
+  uint32_t refs;
+  uint16_t next; // free list link
+} frame_t;
+
+struct frame_pool {
+  frame_t *frames;
+  size_t frame_size;
+  uint16_t count;
+  uint32_t head;      // tag << 16 | index of first free frame
+  uint32_t available; // frames on the free list
+};
+
+/**
+ * @brief define a frame pool
+ * @param name pool name
+ * @param count number of frames, at most FRAME_POOL_MAX
+ * @param size bytes per frame
+ * @note call frame_pool_init(FRAME_POOL_PTR(name), ...) once before use
+ */
+#define FRAME_POOL_DEFINE(name, count, size)                                   \
+  static frame_t _frame_pool_frames_##name[count];                             \
+  static char _frame_pool_buffer_##name[(count) * (size)];                     \
+  frame_pool_t _frame_pool_##name;
+
+/**
+ * @brief initialize a pool defined by FRAME_POOL_DEFINE
+ */
+#define FRAME_POOL_INIT(name, count, size)                                     \
+  frame_pool_init(&_frame_pool_##name, _frame_pool_frames_##name,              \
+                  _frame_pool_buffer_##name, count, size)
+
+/**
+ * @brief return pool's pointer
+ */
+#define FRAME_POOL_PTR(name) (&_frame_pool_##name)
+
+/**
+ * @brief initialize pool, all frames free
+ *
+ * @param pool
+ * @param frames count frame headers
+ * @param buffer count * frame_size bytes
+ * @param count 1 ~ FRAME_POOL_MAX
+ * @param frame_size
+ */
+void frame_pool_init(frame_pool_t *pool, frame_t *frames, char *buffer,
+                     uint16_t count, size_t frame_size);
+
+/**
+ * @brief take a frame from the pool
+ *
+ * @param pool
+ * @return frame_t* with one reference and len 0, NULL if the pool is empty
+ */
+frame_t *frame_alloc(frame_pool_t *pool);
+
+/**
+ * @brief add a reference
+ *
+ * @param frame
+ * @return frame_t* frame, to pass along in one expression
+ */
+frame_t *frame_ref(frame_t *frame);
+
+/**
+ * @brief drop a reference, the last one returns frame to its pool
+ *
+ * @param frame
+ */
+void frame_unref(frame_t *frame);
+
+/**
+ * @brief number of free frames, a snapshot under concurrent use
+ *
+ * @param pool
+ * @return size_t
+ */
+size_t frame_pool_available(frame_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file protocal_uart.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief framing helpers bound to a uart_t
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * protocal_utils.h only knows fifos; the parts that need the uart itself,
+ * rx arrival marks and committing an encoded frame to the tx_fifo, live
+ * here so the framing layer builds without the uart driver.
+ */
+#pragma once
+
+#include <protocal_utils.h>
+#include <uart_utils.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if UART_RX_MARKS
+typedef struct {
+  fifo_t *marks;
+  uart_rx_mark_t cur; // latest mark at or before the fifo head
+  bool valid;
+} protocal_ts_t;
+
+/**
+ * @brief initialize timestamp context
+ *
+ * @param ts
+ * @param marks mark fifo given to uart_set_rx_marks
+ */
+void protocal_ts_init(protocal_ts_t *ts, fifo_t *marks);
+
+/**
+ * @brief find frame in fifo and the arrival time of its first byte
+ *
+ * The time is the one of the latest mark at or before the first byte, i.e.
+ * exact for the first byte of a chunk and a lower bound otherwise. Marks
+ * of consumed bytes are retired, so use this for every read of the fifo.
+ *
+ * @param[in,out] fifo
+ * @param[in] fn match function
+ * @param[out] dest buffer
+ * @param[in] dest buffer max size
+ * @param[in,out] ts
+ * @param[out] time arrival time, untouched if no frame or no mark
+ * @return N > 0 find a frame, frame size is N bytes
+ * @return N = 0 no frame found
+ */
+int protocal_find_frame_ts(fifo_t *fifo, protocal_match_fn_t fn, void *buffer,
+                           size_t buff_size, protocal_ts_t *ts,
+                           utils_tick_t *time);
+#endif
+
+/**
+ * @brief protocal_enc_end for the tx_fifo of a uart, starts transmit
+ *
+ * @param enc begun on inst->tx_fifo
+ * @param inst
+ * @return size_t frame bytes committed
+ */
+size_t protocal_enc_end_uart(protocal_enc_t *enc, uart_t *inst);
+
+#ifdef __cplusplus
+}
+#endif
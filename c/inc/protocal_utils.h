@@ -12,11 +12,16 @@
 
 #include <fifo_utils.h>
 #include <stdbool.h>
+#include <timer_utils.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// pool_utils.h, only handled through pointers here
+struct frame_s;
+struct frame_pool;
+
 /**
  * @brief match function of
  *
@@ -42,6 +47,171 @@ typedef int (*protocal_match_fn_t)(fifo_t *ptr);
 int protocal_find_frame(fifo_t *fifo, protocal_match_fn_t fn, void *buffer,
                         size_t buff_size);
 
+/**
+ * @brief find frame in fifo and move it into a pool frame
+ *
+ * A frame is only taken from pool once the matcher found one, while the
+ * pool is empty the frame stays in fifo and NULL is returned.
+ *
+ * @param[in,out] fifo
+ * @param[in] fn match function
+ * @param[in] pool
+ * @return frame_t* frame with one reference and len bytes, NULL if no frame
+ * was found, it does not fit a pool frame or the pool is empty
+ */
+struct frame_s *protocal_find_frame_pool(fifo_t *fifo, protocal_match_fn_t fn,
+                                         struct frame_pool *pool);
+
+typedef struct {
+  fifo_t *fifo;
+  protocal_match_fn_t fn;
+  timer_wheel_t *wheel;
+  utils_tick_t byte_timeout;  // max gap between bytes of a frame, 0 off
+  utils_tick_t frame_timeout; // max time a partial frame may wait, 0 off
+  timer_node_t timer;
+  size_t seen;             // fifo_len at the end of the last call
+  utils_tick_t last_byte;  // when seen last grew
+  utils_tick_t frame_start; // when the head partial frame was first seen
+  bool partial;            // matcher is waiting for more bytes
+  // statistics
+  uint32_t expired; // partial frames dropped by a timeout
+  uint32_t dropped; // bytes dropped by a timeout
+} protocal_stream_t;
+
+/**
+ * @brief initialize a stream with timeouts for partial frames
+ *
+ * A matcher returning 0 keeps a truncated frame at the fifo head until
+ * later bytes complete or break it. A stream remembers when its fifo last
+ * grew and when the matcher started waiting. On byte_timeout without new
+ * bytes the line went quiet and stale bytes are dropped up to the next
+ * complete frame; on frame_timeout with bytes still trickling in only the
+ * head byte is dropped, so the matcher resyncs on the rest. Arrival is sampled by
+ * protocal_stream_find, call it at least once per byte_timeout while
+ * bytes arrive, the timeouts are a lower bound with that resolution.
+ *
+ * @param stream
+ * @param fifo rx fifo
+ * @param fn match function
+ * @param wheel timer wheel giving the time, shared by many streams
+ * @param byte_timeout ticks, 0 disables
+ * @param frame_timeout ticks, 0 disables
+ */
+void protocal_stream_init(protocal_stream_t *stream, fifo_t *fifo,
+                          protocal_match_fn_t fn, timer_wheel_t *wheel,
+                          utils_tick_t byte_timeout,
+                          utils_tick_t frame_timeout);
+
+/**
+ * @brief protocal_find_frame for a stream, arms its timeouts
+ *
+ * @param stream
+ * @param[out] buffer
+ * @param buff_size
+ * @return N > 0 find a frame, frame size is N bytes
+ * @return N = 0 no frame found
+ */
+int protocal_stream_find(protocal_stream_t *stream, void *buffer,
+                         size_t buff_size);
+
+/**
+ * @brief stop the timeouts of a stream
+ *
+ * @param stream
+ */
+void protocal_stream_deinit(protocal_stream_t *stream);
+
+typedef enum {
+  protocal_enc_cobs,    // COBS, 0x00 terminated
+  protocal_enc_slip,    // RFC 1055, END on both sides
+  protocal_enc_len_crc, // u16 le length, payload, u16 le crc16 of payload
+} protocal_enc_type_t;
+
+typedef struct {
+  fifo_t *fifo;
+  protocal_enc_type_t type;
+  size_t start; // fifo index of the first frame byte
+  size_t pos;   // frame bytes written so far
+  size_t room;  // frame bytes reserved
+  size_t code;  // cobs: frame offset of the open code byte
+  size_t len;   // payload bytes written so far
+  size_t max;   // max_payload given to protocal_enc_begin
+  uint16_t crc;
+} protocal_enc_t;
+
+/**
+ * @brief worst case frame size of an encoding
+ *
+ * @param type
+ * @param max_payload
+ * @return size_t
+ */
+size_t protocal_enc_size(protocal_enc_type_t type, size_t max_payload);
+
+/**
+ * @brief update a CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ *
+ * @param crc 0xFFFF to start
+ * @param data
+ * @param len
+ * @return uint16_t
+ */
+uint16_t protocal_crc16(uint16_t crc, const void *data, size_t len);
+
+/**
+ * @brief start a frame encoded straight into fifo storage
+ *
+ * The worst case frame size for max_payload must be free in fifo. Bytes
+ * are stuffed/escaped and checksummed in one pass while they are written
+ * and are not visible to the consumer before protocal_enc_end. The encoder
+ * is the producer of fifo until then.
+ *
+ * @param enc
+ * @param fifo item size 1, e.g. the tx_fifo of a uart
+ * @param type
+ * @param max_payload payload bytes protocal_enc_write may take in total,
+ * at most UINT16_MAX for protocal_enc_len_crc
+ * @return true space reserved
+ * @return false not enough free space or max_payload too large, nothing
+ * changed
+ */
+bool protocal_enc_begin(protocal_enc_t *enc, fifo_t *fifo,
+                        protocal_enc_type_t type, size_t max_payload);
+
+/**
+ * @brief encode payload bytes
+ *
+ * @param enc
+ * @param data
+ * @param len
+ * @return size_t bytes taken, less than len once max_payload is reached
+ */
+size_t protocal_enc_write(protocal_enc_t *enc, const void *data, size_t len);
+
+/**
+ * @brief close the frame without committing it
+ *
+ * @note commit exactly the returned bytes, e.g. with uart_write_commit
+ * @param enc
+ * @return size_t frame bytes to commit
+ */
+size_t protocal_enc_finish(protocal_enc_t *enc);
+
+/**
+ * @brief close the frame and commit its exact length to fifo
+ *
+ * @param enc
+ * @return size_t frame bytes committed
+ */
+size_t protocal_enc_end(protocal_enc_t *enc);
+
+/**
+ * @brief drop the frame, nothing is committed
+ *
+ * @param enc
+ */
+void protocal_enc_abort(protocal_enc_t *enc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,129 @@
+/**
+ * @file timer_utils.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief hashed timer wheel for many short timeouts
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Timers are intrusive nodes in slot_count doubly linked lists, slot
+ * (expire >> shift) & (slot_count - 1). Adding, moving and cancelling a
+ * timer is O(1), timer_wheel_advance only walks the slots passed since the
+ * last call, timers that are a full turn or more away stay in their slot.
+ * Expiry is compared wrap around safe, so a timer may be at most
+ * UTILS_TICK_MAX / 2 ticks ahead of the wheel: 2.1 s with a 32 bit ns tick,
+ * unlimited in practice with the 64 bit host default. The wheel is not
+ * thread safe, drive it from the context that owns the timers, e.g. the
+ * main loop that also parses the rx fifos.
+ *
+ * @code
+ *
+ * static timer_node_t slots[64];
+ * static timer_wheel_t wheel;
+ *
+ * timer_wheel_init(&wheel, slots, 64, 0, utils_clock_now());
+ * timer_init(&node, on_timeout);
+ * timer_start(&wheel, &node, 20);
+ * for (;;)
+ *   timer_wheel_advance(&wheel, utils_clock_now());
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "clock_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct timer_node timer_node_t;
+
+/**
+ * @brief called once when the timer expires, may add or cancel any timer
+ */
+typedef void (*timer_fn_t)(timer_node_t *node);
+
+struct timer_node {
+  timer_node_t *next, *prev; // NULL when not pending
+  utils_tick_t expire;
+  timer_fn_t fn;
+};
+
+typedef struct {
+  timer_node_t *slots; // list heads
+  size_t slot_count;
+  unsigned shift;   // a slot covers 1 << shift ticks
+  utils_tick_t now; // time of the last advance
+} timer_wheel_t;
+
+/**
+ * @brief initialize wheel
+ *
+ * @param wheel
+ * @param slots slot_count list heads
+ * @param slot_count must be 2^x
+ * @param shift a slot covers 1 << shift ticks
+ * @param now current time
+ */
+void timer_wheel_init(timer_wheel_t *wheel, timer_node_t *slots,
+                      size_t slot_count, unsigned shift, utils_tick_t now);
+
+/**
+ * @brief initialize a timer, not pending
+ *
+ * @param node
+ * @param fn
+ */
+void timer_init(timer_node_t *node, timer_fn_t fn);
+
+/**
+ * @brief start or move a timer
+ *
+ * @note expire at or before wheel->now fires on the next advance, so does
+ * one more than UTILS_TICK_MAX / 2 after it
+ * @param wheel
+ * @param node
+ * @param expire absolute tick
+ */
+void timer_add(timer_wheel_t *wheel, timer_node_t *node, utils_tick_t expire);
+
+/**
+ * @brief start or move a timer timeout ticks after wheel->now
+ *
+ * @param wheel
+ * @param node
+ * @param timeout < UTILS_TICK_MAX / 2
+ */
+void timer_start(timer_wheel_t *wheel, timer_node_t *node,
+                 utils_tick_t timeout);
+
+/**
+ * @brief stop a timer, nothing happens if it is not pending
+ *
+ * @param node
+ */
+void timer_cancel(timer_node_t *node);
+
+/**
+ * @brief check timer is pending
+ */
+static inline bool timer_pending(const timer_node_t *node) {
+  return node->next != NULL;
+}
+
+/**
+ * @brief fire all timers expired at now
+ *
+ * @param wheel
+ * @param now current time, not before the last advance
+ * @return size_t number of timers fired
+ */
+size_t timer_wheel_advance(timer_wheel_t *wheel, utils_tick_t now);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file trace_utils.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief binary event trace ring for isr and protocol activity
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * With UTILS_TRACE set, TRACE() stores a fixed size record (tick, event id,
+ * instance, argument) in the global trace_ring: one atomic increment, one
+ * tick read and four stores, no formatting. The ring is a flight recorder,
+ * old records are overwritten. Dump trace_ring from a debugger or copy it
+ * at run time and decode it with trace_order / trace_span_stats, or the
+ * trace_decode host tool.
+ *
+ * @code
+ *
+ * // gdb: dump binary value trace.bin trace_ring
+ * // host: trace_decode trace.bin
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "clock_utils.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef UTILS_TRACE
+#define UTILS_TRACE 0
+#endif
+
+#ifndef TRACE_RING_LEN
+#define TRACE_RING_LEN 1024 // records, must be 2^x
+#endif
+
+typedef enum {
+  trace_none = 0,
+  trace_uart_isr_rx_enter,
+  trace_uart_isr_rx_exit,
+  trace_uart_isr_tx_enter,
+  trace_uart_isr_tx_exit,
+  trace_uart_rx_overflow,
+  trace_protocal_find_enter,
+  trace_protocal_find_exit, // arg: frame size or 0
+  trace_protocal_expire,    // arg: stale bytes dropped
+  trace_user = 0x100,       // first id free for applications
+} trace_event_t;
+
+typedef struct {
+  uint32_t time;
+  uint16_t event;
+  uint16_t inst;
+  uint32_t arg;
+} trace_record_t;
+
+typedef struct {
+  uint32_t len;  // records in the ring, lets host tools decode any size
+  uint32_t head; // records written so far
+  trace_record_t records[TRACE_RING_LEN];
+} trace_ring_t;
+
+extern trace_ring_t trace_ring;
+
+/**
+ * @brief store one record into trace_ring
+ *
+ * @param event
+ * @param inst instance key, see TRACE_INST
+ * @param arg
+ */
+static inline void trace_emit(uint16_t event, uint16_t inst, uint32_t arg) {
+  uint32_t i = __atomic_fetch_add(&trace_ring.head, 1, __ATOMIC_RELAXED);
+  trace_record_t *r = &trace_ring.records[i & (TRACE_RING_LEN - 1)];
+  r->time = (uint32_t)utils_clock_now();
+  r->event = event;
+  r->inst = inst;
+  r->arg = arg;
+}
+
+/**
+ * @brief 16 bit key of an instance pointer
+ */
+#define TRACE_INST(ptr) ((uint16_t)((uintptr_t)(ptr) >> 2))
+
+#if UTILS_TRACE
+#define TRACE(event, ptr, arg) trace_emit(event, TRACE_INST(ptr), arg)
+#else
+#define TRACE(event, ptr, arg) ((void)0)
+#endif
+
+typedef struct {
+  uint16_t enter; // event id opening the span
+  uint16_t exit;  // event id closing the span
+  uint32_t count;
+  uint32_t min, max; // ticks
+  uint64_t total;    // ticks
+} trace_span_stat_t;
+
+/**
+ * @brief copy records of a ring in write order, oldest first
+ *
+ * @param records ring records, e.g. trace_ring.records or a dump of them
+ * @param len ring length, 2^x
+ * @param head records written so far
+ * @param[out] out at least len records
+ * @return size_t number of records copied
+ */
+size_t trace_order(const trace_record_t *records, uint32_t len, uint32_t head,
+                   trace_record_t *out);
+
+/**
+ * @brief latency of enter/exit pairs, matched per instance
+ *
+ * @param rec records in write order
+ * @param num
+ * @param[in,out] stat enter/exit filled by caller, the rest is computed
+ */
+void trace_span_stats(const trace_record_t *rec, size_t num,
+                      trace_span_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
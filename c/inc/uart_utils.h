@@ -49,8 +49,11 @@
  */
 #pragma once
 
+#include "capture_utils.h"
+#include "clock_utils.h"
 #include "fifo_utils.h"
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,16 +75,173 @@ typedef enum {
   uart_status_err,
 } uart_status_t;
 
+#ifndef UART_UTILS_STATS
+#define UART_UTILS_STATS 0
+#endif
+
+#ifndef UART_STATS_LATENCY_BUCKETS
+#define UART_STATS_LATENCY_BUCKETS 24
+#endif
+
+#if UART_UTILS_STATS
+typedef struct {
+  uint32_t bytes_rx;    // bytes pushed into rx_fifo
+  uint32_t bytes_tx;    // bytes handed to the transmitter
+  uint32_t isr_rx;      // uart_isr_handle_rx calls
+  uint32_t isr_tx;      // uart_isr_handle_tx calls
+  uint32_t rx_overflow; // bytes lost because rx_fifo was full
+  uint32_t rx_filtered; // bytes dropped by the rx address filter
+  uint32_t rx_abort;    // rx aborted by overflow, tx takeover or disable
+  uint32_t tx_restart;  // transmitter started from idle/rx
+  // time rx/tx_fifo spent full, one full period is measured modulo the
+  // utils_tick_t range. tx counts from a uart_write or uart_write_commit
+  // that fills tx_fifo, or a uart_write_prio refused for lack of room, to the
+  // next tx isr
+  uint64_t rx_full_ticks;
+  uint64_t tx_full_ticks;
+  // byte-to-consumer latency, bucket n counts [2^(n-1), 2^n) ticks
+  uint32_t latency[UART_STATS_LATENCY_BUCKETS];
+  // internal bookkeeping
+  utils_tick_t rx_full_since, tx_full_since;
+  utils_tick_t sample_time;
+  uint32_t sample_seq;
+  bool rx_full, tx_full, sample_pending;
+} uart_stats_t;
+#endif
+
+// framed tx queues above tx_fifo, e.g. 2, 0 compiles them out
+#ifndef UART_TX_PRIO_LEVELS
+#define UART_TX_PRIO_LEVELS 0
+#endif
+
+// rx arrival timestamps, see uart_set_rx_marks, 1 to compile them in
+#ifndef UART_RX_MARKS
+#define UART_RX_MARKS 0
+#endif
+
+#if UART_RX_MARKS
+typedef struct {
+  size_t index;      // rx_fifo position of the first byte of a chunk
+  utils_tick_t time; // arrival time of that byte
+} uart_rx_mark_t;
+#endif
+
+// rx/tx byte capture, see uart_set_capture, 1 to compile it in
+#ifndef UART_CAPTURE
+#define UART_CAPTURE 0
+#endif
+
+// rs-485 multidrop address filter, see uart_set_rx_filter, 1 to compile
+// it in
+#ifndef UART_RX_FILTER
+#define UART_RX_FILTER 0
+#endif
+
+// uart_filter_start: most bytes held back before the address decides
+#ifndef UART_RX_FILTER_HOLD
+#define UART_RX_FILTER_HOLD 4
+#endif
+
+typedef struct uart uart_t;
+
+#if UART_RX_FILTER
+typedef enum {
+  // every frame begins with start, the address is addr_offset bytes later
+  uart_filter_start = 0,
+  // 9 bit mode, the backend flags address bytes with uart_rx_addr_mark
+  uart_filter_addr_mark,
+} uart_filter_mode_t;
+
+typedef struct {
+  uint32_t accept[8]; // bit n set: frames for address n are received
+  uart_filter_mode_t mode;
+  char start;          // uart_filter_start only
+  uint8_t addr_offset; // uart_filter_start only, 1..UART_RX_FILTER_HOLD
+  // uart_filter_addr_mark only, called from isr when a frame for another
+  // node begins, e.g. enter the hardware's mute mode, may be NULL
+  void (*mute)(uart_t *inst, void *privdata);
+} uart_rx_filter_t;
+#endif
+
+typedef enum {
+  uart_event_rx_threshold = 0x01, // rx fifo reached rx_threshold bytes
+  uart_event_tx_drained = 0x02,   // tx fifo is empty, transmission done
+  uart_event_rx_overflow = 0x04,  // rx fifo was full, a byte is lost
+  uart_event_tx_space = 0x08,     // tx fifo dropped to half its capacity
+} uart_event_t;
+
+#define UART_WAIT_FOREVER UINT32_MAX
+
+/**
+ * @brief block until tx_wake is called or timeout ticks elapsed
+ *
+ * @param inst
+ * @param timeout ticks to wait at most, UART_WAIT_FOREVER for no limit
+ * @return uint32_t ticks actually waited
+ */
+typedef uint32_t (*uart_tx_wait_fn_t)(uart_t *inst, uint32_t timeout);
+
+/**
+ * @brief event handler
+ *
+ * @param inst
+ * @param events mask of uart_event_t
+ * @param userdata
+ */
+typedef void (*uart_event_fn_t)(uart_t *inst, unsigned events,
+                                void *userdata);
+
 typedef struct {
+  uart_event_fn_t fn;
+  // called from isr when a deferred event got latched, may be NULL
+  void (*wake)(uart_t *inst, void *userdata);
+  void *userdata;
+  unsigned events;     // mask of enabled events
+  unsigned deferred;   // events latched for uart_dispatch_events
+  size_t rx_threshold; // >= 1
+} uart_event_cfg_t;
+
+struct uart {
   const uart_io_t *io;
   fifo_t *rx_fifo;
   fifo_t *tx_fifo;
   void *privdata;
+  const uart_event_cfg_t *event_cfg;
+  unsigned event_pending;
+  uart_tx_wait_fn_t tx_wait;
+  void (*tx_wake)(uart_t *inst); // called from isr
+  bool tx_waiting;
+#if UART_TX_PRIO_LEVELS
+  fifo_t *tx_queue[UART_TX_PRIO_LEVELS];
+  uint16_t tx_frame_left; // bytes of the frame in flight
+  size_t tx_plain_left;   // tx_fifo bytes to send before a level may start
+  uint8_t tx_frame_level;
+#endif
+#if UART_RX_MARKS
+  fifo_t *rx_marks;
+  utils_tick_t rx_mark_time; // given by uart_rx_mark for the next byte
+  uint16_t rx_mark_interval, rx_mark_left;
+  bool rx_mark_pending;
+#endif
+#if UART_CAPTURE
+  capture_t *capture;
+  uint8_t capture_chan;
+#endif
+#if UART_RX_FILTER
+  const uart_rx_filter_t *rx_filter;
+  char rx_hold[UART_RX_FILTER_HOLD]; // start byte and bytes up to the address
+  uint8_t rx_filter_pos;   // bytes of the current frame before its address
+  uint8_t rx_filter_state; // hunt, header, pass or drop
+  bool rx_addr_mark;       // next byte is an address byte
+#endif
+#if UART_UTILS_STATS
+  uart_stats_t stats;
+#endif
   char rx_tmp, tx_tmp;
   uart_status_t status : 2;
   bool tx_enable : 1;
   bool rx_enable : 1;
-} uart_t;
+};
 
 /**
  * @brief initialize uart instance, turn to idle
@@ -105,6 +265,84 @@ void uart_init(uart_t *inst, const uart_io_t *io, void *private_data,
  */
 size_t uart_write(uart_t *inst, const char *c, size_t num);
 
+/**
+ * @brief reserve space in tx buffer to encode data in place
+ *
+ * @note only the part before tx_fifo wraps is returned, commit and reserve
+ * again for the rest
+ * @param inst
+ * @param[out] buf first free byte of tx_fifo
+ * @param num bytes wanted
+ * @return size_t bytes available at *buf, no more than num
+ */
+size_t uart_write_reserve(uart_t *inst, char **buf, size_t num);
+
+/**
+ * @brief publish reserved bytes and start transmit
+ *
+ * @param inst
+ * @param num bytes written at the reserved buffer
+ */
+void uart_write_commit(uart_t *inst, size_t num);
+
+/**
+ * @brief write all data into tx buffer, wait for space if it's full
+ *
+ * Waiting uses the hooks registered by uart_set_tx_wait, without them
+ * this behaves like uart_write.
+ *
+ * @param inst
+ * @param c
+ * @param num
+ * @param timeout ticks to wait at most, UART_WAIT_FOREVER for no limit
+ * @return size_t actually data writen in buffer, less than num on timeout
+ */
+size_t uart_write_all(uart_t *inst, const char *c, size_t num,
+                      uint32_t timeout);
+
+/**
+ * @brief register blocking hooks for uart_write_all
+ *
+ * wake is called from isr once tx_fifo is at most half full while a writer
+ * waits, e.g. give a semaphore that wait takes.
+ *
+ * @param inst
+ * @param wait
+ * @param wake
+ */
+void uart_set_tx_wait(uart_t *inst, uart_tx_wait_fn_t wait,
+                      void (*wake)(uart_t *inst));
+
+#if UART_TX_PRIO_LEVELS
+/**
+ * @brief attach a framed tx queue of a priority level
+ *
+ * The tx isr starts a new frame from the highest non-empty level once the
+ * frame in flight is done, so an urgent frame waits for at most one frame of
+ * a lower level. Plain tx_fifo data ranks below every level and is sent as
+ * one frame of everything committed when its first byte went out, so a
+ * level only cuts in at the end of a uart_write or uart_write_commit.
+ *
+ * @param inst
+ * @param level 0..UART_TX_PRIO_LEVELS-1, higher is more urgent
+ * @param fifo item size 1, NULL to detach, must be empty when detached
+ */
+void uart_set_tx_queue(uart_t *inst, unsigned level, fifo_t *fifo);
+
+/**
+ * @brief queue a whole frame on a priority level and start transmit
+ *
+ * @note a frame takes num + 2 bytes of the level's fifo
+ * @param inst
+ * @param level
+ * @param c
+ * @param num 1..UINT16_MAX
+ * @return size_t num, or 0 if the frame doesn't fit
+ */
+size_t uart_write_prio(uart_t *inst, unsigned level, const char *c,
+                       size_t num);
+#endif
+
 /**
  * @brief read data from rx buffer
  *
@@ -115,6 +353,99 @@ size_t uart_write(uart_t *inst, const char *c, size_t num);
  */
 size_t uart_read(uart_t *inst, char *c, size_t num);
 
+#if UART_RX_MARKS
+/**
+ * @brief record rx arrival times into a side fifo of uart_rx_mark_t
+ *
+ * The rx isr pushes one mark when a byte lands in an empty rx_fifo, every
+ * interval bytes after that and for the byte following uart_rx_mark. Marks
+ * are retired by protocal_find_frame_ts. When marks is full new marks are
+ * skipped, later bytes then resolve to an older time.
+ *
+ * @param inst
+ * @param marks item type uart_rx_mark_t, NULL to disable
+ * @param interval bytes between two marks of a burst, 0 for none
+ */
+void uart_set_rx_marks(uart_t *inst, fifo_t *marks, uint16_t interval);
+
+/**
+ * @brief stamp the next received byte with time
+ *
+ * @note for chunk based backends (dma, fd), call once per chunk with the
+ * time the chunk completed, before handing its bytes to the isr handler
+ * @param inst
+ * @param time
+ */
+void uart_rx_mark(uart_t *inst, utils_tick_t time);
+#endif
+
+#if UART_CAPTURE
+/**
+ * @brief record every received byte and every byte handed to the
+ * transmitter
+ *
+ * @note capture_write runs in isr context, the sink too when the staging
+ * buffer fills up
+ * @param inst
+ * @param cap NULL to stop capturing
+ * @param chan channel id stored in the records
+ */
+void uart_set_capture(uart_t *inst, capture_t *cap, uint8_t chan);
+#endif
+
+#if UART_RX_FILTER
+/**
+ * @brief clear the address table and set the mode
+ *
+ * @param filter
+ * @param mode
+ */
+void uart_filter_init(uart_rx_filter_t *filter, uart_filter_mode_t mode);
+
+/**
+ * @brief receive or ignore frames for an address
+ *
+ * @param filter
+ * @param addr
+ * @param accept
+ */
+void uart_filter_accept(uart_rx_filter_t *filter, uint8_t addr, bool accept);
+
+/**
+ * @brief drop frames for other nodes in the rx isr
+ *
+ * Bytes of frames whose address byte is not in filter->accept never reach
+ * rx_fifo, neither do bytes before the first frame start. In
+ * uart_filter_start mode the start byte always begins a new frame, the
+ * bytes before the address are held back until it arrives. Accepted frames
+ * reach rx_fifo complete, including start and address.
+ *
+ * @param inst
+ * @param filter must outlive inst, NULL to receive everything
+ */
+void uart_set_rx_filter(uart_t *inst, const uart_rx_filter_t *filter);
+
+/**
+ * @brief bytes held back by the filter, waiting for the frame address
+ *
+ * They reach rx_fifo together with the address byte, so a backend feeding
+ * n bytes needs room for n + uart_rx_held bytes.
+ *
+ * @param inst
+ * @return size_t
+ */
+size_t uart_rx_held(const uart_t *inst);
+
+/**
+ * @brief flag the next received byte as an address byte (9th bit set)
+ *
+ * @note for uart_filter_addr_mark, call from the backend before handing
+ * the byte to uart_isr_handle_rx
+ * @param inst
+ */
+void uart_rx_addr_mark(uart_t *inst);
+#endif
+
 /**
  * @brief enable async transmit
  *
@@ -151,6 +482,52 @@ void uart_disable_rx(uart_t *inst);
  */
 uart_status_t uart_status(uart_t *inst);
 
+/**
+ * @brief register event handler
+ *
+ * Events not in cfg->deferred are delivered from the isr/backend path, the
+ * others are latched and delivered by uart_dispatch_events, so the main loop
+ * can sleep until cfg->wake fires instead of polling uart_read/uart_status.
+ *
+ * @param inst
+ * @param cfg must outlive inst, NULL to disable events
+ */
+void uart_set_event_cfg(uart_t *inst, const uart_event_cfg_t *cfg);
+
+/**
+ * @brief deliver latched deferred events, call from main loop
+ *
+ * @param inst
+ * @return unsigned mask of delivered events
+ */
+unsigned uart_dispatch_events(uart_t *inst);
+
+#if UART_UTILS_STATS
+/**
+ * @brief get statistics of inst
+ *
+ * @param inst
+ * @return const uart_stats_t*
+ */
+const uart_stats_t *uart_stats(uart_t *inst);
+
+/**
+ * @brief clear statistics of inst
+ *
+ * @param inst
+ */
+void uart_stats_reset(uart_t *inst);
+
+/**
+ * @brief account bytes consumed from rx_fifo without uart_read
+ *
+ * @note call after protocal_find_frame or fifo_pop on inst->rx_fifo, or the
+ * latency histogram misses those bytes
+ * @param inst
+ */
+void uart_stats_update(uart_t *inst);
+#endif
+
 /**
  * @brief rx isr handler
  *
@@ -0,0 +1,121 @@
+/**
+ * @file capture_replay.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief mmap based replay of capture files into the protocol layer
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * A capture written by capture_utils is mapped read only and the payload of
+ * one channel/direction is copied into a fifo_t in chunks as large as the
+ * fifo allows, then protocal_find_frame_ts runs over it. Record times are
+ * turned into rx marks, so every frame reports the capture time of its
+ * first byte. Built with UART_RX_MARKS=0 there are no marks and a frame
+ * reports the time of the record that completed it. Nothing waits on wall
+ * clock time, replay runs at memory speed.
+ *
+ * @code
+ *
+ * capture_file_t file;
+ * capture_open(&file, "field.ucap");
+ * capture_replay(&file, 0, capture_rx, &replay, on_frame, NULL);
+ * capture_close(&file);
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "capture_utils.h"
+#include "protocal_uart.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  const char *base;
+  size_t size;
+  size_t pos; // next record
+  uint32_t tick_ns;
+  uint32_t time_hi;  // from the last capture_time record
+  utils_tick_t time; // full tick of the record capture_next returned last
+} capture_file_t;
+
+/**
+ * @brief called for every frame found during replay
+ *
+ * @param frame valid only during the call
+ * @param len
+ * @param time capture tick of the first byte, of the last one without
+ * UART_RX_MARKS
+ * @param userdata
+ */
+typedef void (*capture_frame_fn_t)(const char *frame, size_t len,
+                                   utils_tick_t time, void *userdata);
+
+typedef struct {
+  fifo_t *fifo;  // item size 1, sized like the target's rx_fifo or larger
+#if UART_RX_MARKS
+  fifo_t *marks; // item type uart_rx_mark_t
+#endif
+  protocal_match_fn_t match;
+  char *frame_buf;
+  size_t frame_size;
+  // results
+  uint64_t bytes;
+  uint64_t frames;
+  uint64_t stalled; // bytes dropped because a full fifo held no frame
+} capture_replay_t;
+
+/**
+ * @brief map a capture file and check its header
+ *
+ * @param file
+ * @param path
+ * @return int 0 on success, -errno otherwise, -EINVAL for bad format
+ */
+int capture_open(capture_file_t *file, const char *path);
+
+/**
+ * @brief unmap capture file
+ *
+ * @param file
+ */
+void capture_close(capture_file_t *file);
+
+/**
+ * @brief read the next record
+ *
+ * capture_time records are consumed here, file->time holds the unwrapped
+ * tick of rec.
+ *
+ * @param file
+ * @param[out] rec
+ * @param[out] data payload of rec, points into the mapping
+ * @return int 1 on record, 0 at end, -EINVAL on a truncated record
+ */
+int capture_next(capture_file_t *file, capture_record_t *rec,
+                 const char **data);
+
+/**
+ * @brief feed one chan/dir stream of file into the protocol layer
+ *
+ * @note starts at the current position of file, which ends at the end
+ * @param file
+ * @param chan
+ * @param dir
+ * @param replay fifos, matcher and frame buffer, results are accumulated
+ * @param on_frame may be NULL
+ * @param userdata
+ * @return int 0 on success, -EINVAL on a truncated record
+ */
+int capture_replay(capture_file_t *file, uint8_t chan, capture_dir_t dir,
+                   capture_replay_t *replay, capture_frame_fn_t on_frame,
+                   void *userdata);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file fifo_dyn.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief heap backed fifo_t that grows and shrinks by doubling
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * fifo_dyn_t owns a malloc'ed buffer of 2^x items behind a regular fifo_t,
+ * so fifo_len, fifo_pop, fifo_peek, fifo_reserve and friends work on
+ * &dyn->fifo unchanged. fifo_dyn_push doubles the buffer until the items
+ * fit or max_len is reached. A resize copies the wrapped contents to the
+ * front of the new buffer in at most two memcpy, so pushing n items costs
+ * O(n) copies in total. With shrink set, fifo_dyn_pop halves the buffer
+ * once it is less than a quarter full, never below min_len.
+ *
+ * A resize moves the buffer: unlike fifo_t this is not a lock free single
+ * producer single consumer queue, use it from one thread or under a lock.
+ *
+ * @code
+ *
+ * fifo_dyn_t rx;
+ * fifo_dyn_init(&rx, 1, 256, 1 << 20, true);
+ * n = fifo_dyn_push(&rx, buf, len);
+ * protocal_find_frame(&rx.fifo, match, frame, sizeof(frame));
+ * fifo_dyn_deinit(&rx);
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "fifo_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  fifo_t fifo;
+  size_t min_len; // fifo_len bounds, 2^x
+  size_t max_len;
+  bool shrink;
+  uint32_t grows;
+  uint32_t shrinks;
+} fifo_dyn_t;
+
+/**
+ * @brief allocate a fifo of min_len items
+ *
+ * @param dyn
+ * @param type_len item size
+ * @param min_len initial and smallest fifo_len, 2^x, >= 2
+ * @param max_len largest fifo_len, 2^x, >= min_len
+ * @param shrink release memory in fifo_dyn_pop
+ * @return int 0 on success, -ENOMEM
+ */
+int fifo_dyn_init(fifo_dyn_t *dyn, size_t type_len, size_t min_len,
+                  size_t max_len, bool shrink);
+
+/**
+ * @brief free buffer, buffered items are dropped
+ *
+ * @param dyn
+ */
+void fifo_dyn_deinit(fifo_dyn_t *dyn);
+
+/**
+ * @brief grow until num more items fit
+ *
+ * @param dyn
+ * @param num
+ * @return int 0 on success, -ENOSPC if max_len is too small (the fifo is
+ * grown to max_len anyway), -ENOMEM
+ */
+int fifo_dyn_grow(fifo_dyn_t *dyn, size_t num);
+
+/**
+ * @brief halve the buffer while it is less than a quarter full
+ *
+ * @param dyn
+ */
+void fifo_dyn_shrink(fifo_dyn_t *dyn);
+
+/**
+ * @brief grow as needed and push items
+ *
+ * @param dyn
+ * @param[in] data
+ * @param num
+ * @return size_t items pushed, less than num at max_len or out of memory
+ */
+size_t fifo_dyn_push(fifo_dyn_t *dyn, const void *data, size_t num);
+
+/**
+ * @brief pop up to num items, shrink if enabled
+ *
+ * @param dyn
+ * @param[out] data
+ * @param num
+ * @return size_t items popped
+ */
+size_t fifo_dyn_pop(fifo_dyn_t *dyn, void *data, size_t num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file fifo_spill.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief disk backed overflow tier for a fifo_t
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * While the ring holds less than high items pushes go to the ring. Above
+ * it, pushes are appended in large memcpy chunks to memory mapped segments
+ * of one unlinked spill file in dir and stay there until the consumer
+ * drained the ring and the whole spill, then the ring takes over again.
+ * Ring items are therefore always older than spilled items and
+ * fifo_spill_pop keeps push order. The producer maps only the segment it
+ * writes and unmaps a full one as it hands it to kernel writeback, the
+ * consumer maps only the segment it reads and punches a drained one out of
+ * the file. However long a burst, a spill holds one fd and two mappings,
+ * memory stays bounded by the ring plus two segments and disk by the data
+ * not consumed yet.
+ *
+ * One producer thread and one consumer thread, like fifo_t itself.
+ *
+ * @code
+ *
+ * fifo_spill_t spill;
+ * fifo_spill_init(&spill, FIFO_PTR(log), "/var/tmp", 3 * 1024, 64 << 20);
+ * // producer
+ * fifo_spill_push(&spill, line, 1);
+ * // consumer
+ * n = fifo_spill_pop(&spill, lines, 32);
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "fifo_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fifo_spill_seg fifo_spill_seg_t;
+
+struct fifo_spill_seg {
+  fifo_spill_seg_t *next; // set by the producer when it moves on
+  uint64_t offset;        // in the spill file, page aligned
+  size_t size;            // bytes, multiple of the item size
+  size_t written;         // bytes, producer
+  size_t read;            // bytes, consumer
+};
+
+typedef struct {
+  fifo_t *fifo;
+  const char *dir;
+  size_t high;     // ring items that trigger spilling
+  size_t seg_size; // bytes per segment
+  int fd;          // spill file, -1 until the first spill
+  fifo_spill_seg_t stub; // empty segment the list starts with
+  // producer
+  fifo_spill_seg_t *tail;
+  char *wbase; // mapping of tail, NULL if none
+  uint64_t file_end;
+  bool spilling;
+  uint64_t spilled; // items written to disk so far
+  // consumer
+  fifo_spill_seg_t *head;
+  char *rbase; // mapping of head, NULL if none
+  // shared
+  size_t spill_items; // items on disk not consumed yet
+} fifo_spill_t;
+
+/**
+ * @brief attach a spill tier to fifo
+ *
+ * @param spill
+ * @param fifo ring, owned by spill from now on
+ * @param dir directory of the spill file, must outlive spill
+ * @param high 1..fifo_capacity(fifo)
+ * @param seg_size bytes per segment, rounded down to whole items
+ */
+void fifo_spill_init(fifo_spill_t *spill, fifo_t *fifo, const char *dir,
+                     size_t high, size_t seg_size);
+
+/**
+ * @brief drop spilled data and remove the spill file
+ *
+ * @param spill
+ */
+void fifo_spill_deinit(fifo_spill_t *spill);
+
+/**
+ * @brief push items, producer side
+ *
+ * @param spill
+ * @param data
+ * @param num
+ * @return size_t items taken, less than num only if the spill file could
+ * not be created, grown or mapped (errno is set)
+ */
+size_t fifo_spill_push(fifo_spill_t *spill, const void *data, size_t num);
+
+/**
+ * @brief pop items in push order, consumer side
+ *
+ * @param spill
+ * @param[out] data
+ * @param num
+ * @return size_t items popped
+ */
+size_t fifo_spill_pop(fifo_spill_t *spill, void *data, size_t num);
+
+/**
+ * @brief items in ring and on disk
+ *
+ * @param spill
+ * @return size_t
+ */
+size_t fifo_spill_len(fifo_spill_t *spill);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file frame_dispatch.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief hand parsed frames to a pool of worker threads, sharded by key
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Every worker owns a fifo_t of frame handles that only the dispatching
+ * thread pushes to and only the worker pops from, the fifo's acquire /
+ * release indexes make it a lock free spsc queue. A key (port, session)
+ * always hashes to the same worker, so frames of one key are handled in
+ * order while different keys run in parallel. Idle workers sleep on an
+ * eventfd, the dispatcher only writes it when a worker announced sleep.
+ *
+ * frame_dispatch_post is meant for one thread, usually the one running
+ * protocal_find_frame_pool for all ports.
+ *
+ * @code
+ *
+ * frame_t *f;
+ * while ((f = protocal_find_frame_pool(rx, match, pool))) {
+ *   while (frame_dispatch_post(&dispatch, port_id, f) == -EAGAIN)
+ *     sched_yield();
+ * }
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "fifo_utils.h"
+#include "pool_utils.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief frame handler, runs on worker thread
+ *
+ * @note the frame reference is dropped after the call, take one with
+ * frame_ref to keep the frame
+ * @param worker index of the worker thread
+ * @param key
+ * @param frame
+ * @param userdata
+ */
+typedef void (*frame_dispatch_fn_t)(unsigned worker, uint32_t key,
+                                    frame_t *frame, void *userdata);
+
+typedef struct {
+  frame_t *frame;
+  uint32_t key;
+} frame_dispatch_item_t;
+
+typedef struct frame_dispatch frame_dispatch_t;
+
+typedef struct {
+  frame_dispatch_t *owner;
+  fifo_t queue; // item type frame_dispatch_item_t
+  pthread_t thread;
+  int wake_fd;
+  bool sleeping;
+  // metrics, written by one side each
+  uint64_t posted;    // dispatcher
+  uint64_t rejected;  // dispatcher, queue was full
+  uint64_t handled;   // worker
+  size_t max_depth;   // dispatcher, highest depth seen after a post
+} frame_dispatch_worker_t;
+
+struct frame_dispatch {
+  frame_dispatch_worker_t *workers;
+  unsigned count;
+  frame_dispatch_fn_t fn;
+  void *userdata;
+  bool stop;
+};
+
+typedef struct {
+  size_t depth; // frames queued now
+  size_t max_depth;
+  uint64_t posted;
+  uint64_t rejected;
+  uint64_t handled;
+} frame_dispatch_stats_t;
+
+/**
+ * @brief start count worker threads
+ *
+ * @param dispatch
+ * @param workers count workers
+ * @param count
+ * @param buffer count * queue_len frame_dispatch_item_t
+ * @param queue_len items per worker queue, must be 2^x
+ * @param fn
+ * @param userdata
+ * @return int 0 on success, -errno otherwise
+ */
+int frame_dispatch_init(frame_dispatch_t *dispatch,
+                        frame_dispatch_worker_t *workers, unsigned count,
+                        frame_dispatch_item_t *buffer, size_t queue_len,
+                        frame_dispatch_fn_t fn, void *userdata);
+
+/**
+ * @brief worker index handling key
+ *
+ * @param dispatch
+ * @param key
+ * @return unsigned
+ */
+unsigned frame_dispatch_worker(const frame_dispatch_t *dispatch, uint32_t key);
+
+/**
+ * @brief queue frame for the worker of key
+ *
+ * @note single producer, takes over the caller's reference on success
+ * @param dispatch
+ * @param key
+ * @param frame
+ * @return int 0 on success, -EAGAIN if the worker queue is full
+ */
+int frame_dispatch_post(frame_dispatch_t *dispatch, uint32_t key,
+                        frame_t *frame);
+
+/**
+ * @brief snapshot of a worker's queue metrics
+ *
+ * @param dispatch
+ * @param worker
+ * @param[out] stats
+ */
+void frame_dispatch_stats(frame_dispatch_t *dispatch, unsigned worker,
+                          frame_dispatch_stats_t *stats);
+
+/**
+ * @brief handle all queued frames, then stop and join workers
+ *
+ * @note frame_dispatch_stats stays usable afterwards
+ * @param dispatch
+ */
+void frame_dispatch_deinit(frame_dispatch_t *dispatch);
+
+#ifdef __cplusplus
+}
+#endif
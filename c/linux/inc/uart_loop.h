@@ -0,0 +1,243 @@
+/**
+ * @file uart_loop.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief epoll based event loop that drives many fd backed uart_t
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Every port is a uart_t whose io interface is provided by the loop: the
+ * "isr" is replaced by readiness events of a non-blocking fd (tty, pty,
+ * socket). Rx bytes are drained straight into rx_fifo, registered matchers
+ * run through protocal_find_frame and tx_fifo is flushed in chunks.
+ *
+ * A loop is single threaded. To spread ports over several cores, init one
+ * loop per worker, shard ports between them and uart_loop_start() each one.
+ *
+ * @code
+ *
+ * static uart_loop_t loop;
+ * static uart_loop_port_t port;
+ * FIFO_DEFINE(rx, 256, char);
+ * FIFO_DEFINE(tx, 256, char);
+ * static char frame[64];
+ *
+ * static void on_frame(uart_loop_port_t *port, const char *frame,
+ *                      size_t len, void *userdata) {
+ *   uart_write(&port->uart, frame, len);
+ * }
+ *
+ * int main(void) {
+ *   uart_loop_init(&loop);
+ *   uart_loop_add(&loop, &port, open("/dev/ttyS0", O_RDWR),
+ *                 FIFO_PTR(rx), FIFO_PTR(tx));
+ *   uart_loop_set_matcher(&port, match_fn, frame, sizeof(frame), on_frame,
+ *                         NULL);
+ *   uart_enable_rx(&port.uart);
+ *   return uart_loop_run(&loop);
+ * }
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "protocal_utils.h"
+#include "uart_utils.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef UART_LOOP_MAX_EVENTS
+#define UART_LOOP_MAX_EVENTS 64
+#endif
+
+#ifndef UART_LOOP_CHUNK_SIZE
+#define UART_LOOP_CHUNK_SIZE 512
+#endif
+
+typedef struct uart_loop uart_loop_t;
+typedef struct uart_loop_port uart_loop_port_t;
+typedef struct uart_loop_task uart_loop_task_t;
+
+/**
+ * @brief work item run on the loop thread, see uart_loop_post
+ */
+struct uart_loop_task {
+  void (*fn)(uart_loop_task_t *task);
+  uart_loop_task_t *next;
+};
+
+/**
+ * @brief called for every frame found by the port's matcher
+ *
+ * @param port
+ * @param frame frame bytes, valid only during the call
+ * @param len frame size
+ * @param userdata
+ */
+typedef void (*uart_loop_frame_fn_t)(uart_loop_port_t *port,
+                                     const char *frame, size_t len,
+                                     void *userdata);
+
+/**
+ * @brief called once when the fd of a port hung up or failed
+ *
+ * The fd is already removed from the loop, the port may be passed to
+ * uart_loop_remove and the fd closed from here.
+ *
+ * @param port
+ * @param userdata
+ */
+typedef void (*uart_loop_close_fn_t)(uart_loop_port_t *port, void *userdata);
+
+struct uart_loop_port {
+  uart_t uart;
+  uart_loop_t *loop;
+  int fd;
+  char *rx_ptr; // armed rx slot, NULL if rx is not armed
+  bool tx_busy; // a tx byte was handed over and waits for completion
+  bool dirty;
+  bool busy;
+  bool closed;
+  bool polled; // fd is registered in epoll
+  unsigned events; // epoll interest currently registered
+  size_t tx_head, tx_tail;
+  char tx_buf[UART_LOOP_CHUNK_SIZE];
+  protocal_match_fn_t match;
+  uart_loop_frame_fn_t on_frame;
+  void *userdata;
+  char *frame_buf;
+  size_t frame_size;
+  uart_loop_close_fn_t on_close;
+  void *close_userdata;
+  uart_loop_port_t *next_dirty;
+};
+
+struct uart_loop {
+  int epfd;
+  int wake_fd;
+  bool stop;
+  bool started;
+  pthread_t thread;
+  uart_loop_port_t *dirty;
+  uart_loop_task_t *tasks; // posted by other threads, newest first
+  size_t port_num;
+};
+
+/**
+ * @brief initialize loop instance
+ *
+ * @param loop
+ * @return int 0 on success, -errno otherwise
+ */
+int uart_loop_init(uart_loop_t *loop);
+
+/**
+ * @brief release loop resources, ports are not closed
+ *
+ * @param loop
+ */
+void uart_loop_deinit(uart_loop_t *loop);
+
+/**
+ * @brief attach fd to the loop and initialize port->uart on it
+ *
+ * @note fd is turned to non-blocking mode
+ * @param loop
+ * @param port
+ * @param fd
+ * @param rx_fifo
+ * @param tx_fifo
+ * @return int 0 on success, -errno otherwise
+ */
+int uart_loop_add(uart_loop_t *loop, uart_loop_port_t *port, int fd,
+                  fifo_t *rx_fifo, fifo_t *tx_fifo);
+
+/**
+ * @brief detach port from its loop, fd is left open
+ *
+ * @param port
+ */
+void uart_loop_remove(uart_loop_port_t *port);
+
+/**
+ * @brief run match function on every rx chunk
+ *
+ * @param port
+ * @param fn match function, NULL leaves data in rx_fifo for uart_read
+ * @param buffer frame buffer passed to protocal_find_frame
+ * @param buff_size
+ * @param on_frame frame callback
+ * @param userdata
+ */
+void uart_loop_set_matcher(uart_loop_port_t *port, protocal_match_fn_t fn,
+                           char *buffer, size_t buff_size,
+                           uart_loop_frame_fn_t on_frame, void *userdata);
+
+/**
+ * @brief get notified when the port's fd hangs up or fails
+ *
+ * @param port
+ * @param fn close callback, NULL to clear
+ * @param userdata
+ */
+void uart_loop_set_close(uart_loop_port_t *port, uart_loop_close_fn_t fn,
+                         void *userdata);
+
+/**
+ * @brief re-evaluate port after rx_fifo was drained outside of the loop
+ *
+ * @param port
+ */
+void uart_loop_update(uart_loop_port_t *port);
+
+/**
+ * @brief run task->fn on the loop thread during the next iteration
+ *
+ * @note thread safe, task must not be posted again before fn was called
+ * @param loop
+ * @param task
+ */
+void uart_loop_post(uart_loop_t *loop, uart_loop_task_t *task);
+
+/**
+ * @brief wait for events once and handle them
+ *
+ * @param loop
+ * @param timeout_ms -1 for infinite
+ * @return int number of handled events, -errno on failure
+ */
+int uart_loop_run_once(uart_loop_t *loop, int timeout_ms);
+
+/**
+ * @brief handle events until uart_loop_stop() is called
+ *
+ * @param loop
+ * @return int 0 on stop, -errno on failure
+ */
+int uart_loop_run(uart_loop_t *loop);
+
+/**
+ * @brief run uart_loop_run on a new thread
+ *
+ * @param loop
+ * @return int 0 on success, -errno otherwise
+ */
+int uart_loop_start(uart_loop_t *loop);
+
+/**
+ * @brief stop the loop, join its thread if it was started
+ *
+ * @note thread safe
+ * @param loop
+ */
+void uart_loop_stop(uart_loop_t *loop);
+
+#ifdef __cplusplus
+}
+#endif
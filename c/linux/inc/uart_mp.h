@@ -0,0 +1,92 @@
+/**
+ * @file uart_mp.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief multi-producer tx path, several threads write through one uart_t
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Writers claim tx_fifo space with a CAS on a shared reserve index, copy
+ * their frame, then publish it by advancing index_end in claim order, so
+ * frames never interleave. The writer that finds the tx state machine idle
+ * sets the kick flag and calls kick_fn, which must make uart_mp_service run
+ * in the backend context (isr, loop thread) that owns the uart_t.
+ *
+ * @note uart_write / uart_write_reserve must not be used on the same uart_t
+ *
+ * @code
+ *
+ * static uart_mp_t mp;
+ *
+ * uart_loop_add(&loop, &port, fd, FIFO_PTR(rx), FIFO_PTR(tx));
+ * uart_mp_init_loop(&mp, &port);
+ * // from any thread
+ * while (!uart_mp_write(&mp, frame, len))
+ *   sched_yield();
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "uart_loop.h"
+#include "uart_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct uart_mp uart_mp_t;
+
+struct uart_mp {
+  uart_t *inst;
+  size_t reserve; // end of claimed space in tx_fifo, >= index_end
+  bool kick;      // service requested and not run yet
+  void (*kick_fn)(uart_mp_t *mp);
+  void *userdata;
+  uart_loop_task_t task; // used by uart_mp_init_loop
+};
+
+/**
+ * @brief initialize multi-producer writer of inst
+ *
+ * @param mp
+ * @param inst initialized uart_t, tx_fifo item size must be 1
+ * @param kick_fn called by at most one writer per service round
+ * @param userdata
+ */
+void uart_mp_init(uart_mp_t *mp, uart_t *inst, void (*kick_fn)(uart_mp_t *mp),
+                  void *userdata);
+
+/**
+ * @brief initialize multi-producer writer of a uart_loop port, service runs
+ * on the loop thread
+ *
+ * @param mp
+ * @param port
+ */
+void uart_mp_init_loop(uart_mp_t *mp, uart_loop_port_t *port);
+
+/**
+ * @brief write a whole frame into tx_fifo
+ *
+ * @note thread safe, all or nothing
+ * @param mp
+ * @param c
+ * @param num
+ * @return size_t num, or 0 if tx_fifo has not enough space
+ */
+size_t uart_mp_write(uart_mp_t *mp, const char *c, size_t num);
+
+/**
+ * @brief start transmit of published frames, call from backend context
+ *
+ * @param mp
+ */
+void uart_mp_service(uart_mp_t *mp);
+
+#ifdef __cplusplus
+}
+#endif
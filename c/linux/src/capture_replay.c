@@ -0,0 +1,226 @@
+/**
+ * @file capture_replay.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "capture_replay.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int capture_open(capture_file_t *file, const char *path) {
+  capture_header_t header;
+  struct stat st;
+  void *base;
+  int fd, re;
+  assert(file);
+  assert(path);
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    goto fatal1;
+  if (fstat(fd, &st))
+    goto fatal2;
+  if ((size_t)st.st_size < sizeof(header)) {
+    errno = EINVAL;
+    goto fatal2;
+  }
+  base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (base == MAP_FAILED)
+    goto fatal2;
+  memcpy(&header, base, sizeof(header));
+  // version 1 files only lack capture_time records
+  if (header.magic != CAPTURE_MAGIC || !header.version ||
+      header.version > CAPTURE_VERSION ||
+      header.header_size < sizeof(header) ||
+      header.header_size > (size_t)st.st_size) {
+    errno = EINVAL;
+    goto fatal3;
+  }
+  // replay reads front to back once
+  madvise(base, st.st_size, MADV_SEQUENTIAL);
+  close(fd);
+  file->base = (const char *)base;
+  file->size = st.st_size;
+  file->pos = header.header_size;
+  file->tick_ns = header.tick_ns;
+  file->time_hi = 0;
+  file->time = 0;
+  return 0;
+fatal3:
+  re = errno;
+  munmap(base, st.st_size);
+  errno = re;
+fatal2:
+  re = errno;
+  close(fd);
+  errno = re;
+fatal1:
+  return -errno;
+}
+
+void capture_close(capture_file_t *file) {
+  assert(file);
+  munmap((void *)file->base, file->size);
+  file->base = NULL;
+  file->size = file->pos = 0;
+}
+
+int capture_next(capture_file_t *file, capture_record_t *rec,
+                 const char **data) {
+  assert(file);
+  assert(rec);
+  assert(data);
+
+  for (;;) {
+    if (file->pos == file->size)
+      return 0;
+    if (file->size - file->pos < sizeof(*rec))
+      return -EINVAL;
+    memcpy(rec, file->base + file->pos, sizeof(*rec));
+    if (file->size - file->pos - sizeof(*rec) < rec->len)
+      return -EINVAL;
+    *data = file->base + file->pos + sizeof(*rec);
+    file->pos += sizeof(*rec) + rec->len;
+    if (rec->dir != capture_time)
+      break;
+    if (rec->len < sizeof(file->time_hi))
+      return -EINVAL;
+    memcpy(&file->time_hi, *data, sizeof(file->time_hi));
+  }
+  file->time = (utils_tick_t)((uint64_t)file->time_hi << 32 | rec->time);
+  return 1;
+}
+
+typedef struct {
+#if UART_RX_MARKS
+  protocal_ts_t ts;
+#endif
+  utils_tick_t now; // record time of the bytes fed last
+} replay_ctx_t;
+
+static inline bool _replay_marks_full(capture_replay_t *replay) {
+#if UART_RX_MARKS
+  return fifo_full(replay->marks);
+#else
+  (void)replay;
+  return false;
+#endif
+}
+
+static int _replay_find(capture_replay_t *replay, replay_ctx_t *ctx,
+                        utils_tick_t *time) {
+#if UART_RX_MARKS
+  return protocal_find_frame_ts(replay->fifo, replay->match,
+                                replay->frame_buf, replay->frame_size,
+                                &ctx->ts, time);
+#else
+  // without marks the bytes that completed the frame give its time
+  *time = ctx->now;
+  return protocal_find_frame(replay->fifo, replay->match, replay->frame_buf,
+                             replay->frame_size);
+#endif
+}
+
+// find frames until the matcher wants more data
+static void _replay_match(capture_replay_t *replay, replay_ctx_t *ctx,
+                          capture_frame_fn_t on_frame, void *userdata) {
+  fifo_t *fifo = replay->fifo;
+  utils_tick_t time = 0;
+
+  while (fifo_len(fifo)) {
+    size_t len = fifo_len(fifo);
+    int re = _replay_find(replay, ctx, &time);
+    if (re > 0) {
+      replay->frames++;
+      if (on_frame)
+        on_frame(replay->frame_buf, re, time, userdata);
+    } else if (fifo_len(fifo) == len) {
+      break;
+    }
+  }
+}
+
+// copy as much of data as fits, in at most two memcpy
+static size_t _replay_feed(fifo_t *fifo, const char *data, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    void *dst;
+    size_t n = fifo_reserve(fifo, &dst);
+    if (!n)
+      break;
+    if (n > len - done)
+      n = len - done;
+    memcpy(dst, data + done, n);
+    fifo_commit(fifo, n);
+    done += n;
+  }
+  return done;
+}
+
+int capture_replay(capture_file_t *file, uint8_t chan, capture_dir_t dir,
+                   capture_replay_t *replay, capture_frame_fn_t on_frame,
+                   void *userdata) {
+  capture_record_t rec;
+  const char *data;
+  replay_ctx_t ctx;
+  int re;
+  assert(replay);
+  assert(replay->fifo && replay->fifo->type_len == 1);
+#if UART_RX_MARKS
+  assert(replay->marks &&
+         replay->marks->type_len == sizeof(uart_rx_mark_t));
+#endif
+  assert(replay->match && replay->frame_buf);
+
+#if UART_RX_MARKS
+  protocal_ts_init(&ctx.ts, replay->marks);
+#endif
+  ctx.now = 0;
+  while ((re = capture_next(file, &rec, &data)) > 0) {
+    size_t done = 0;
+    if (rec.chan != chan || rec.dir != dir)
+      continue;
+    while (done < rec.len) {
+#if UART_RX_MARKS
+      uart_rx_mark_t mark = {replay->fifo->index_end, file->time};
+#endif
+      size_t n;
+      if (fifo_full(replay->fifo) || _replay_marks_full(replay)) {
+        // matching retires marks as well as bytes
+        _replay_match(replay, &ctx, on_frame, userdata);
+        if (fifo_full(replay->fifo)) {
+          // the matcher neither took nor dropped anything
+          char c;
+          fifo_pop(replay->fifo, &c, 1);
+          replay->stalled++;
+          continue;
+        }
+      }
+      n = _replay_feed(replay->fifo, data + done, rec.len - done);
+#if UART_RX_MARKS
+      // without room for a mark the bytes resolve to an older one
+      if (!fifo_full(replay->marks))
+        fifo_push(replay->marks, &mark, 1);
+#endif
+      ctx.now = file->time;
+      replay->bytes += n;
+      done += n;
+    }
+#if !UART_RX_MARKS
+    // nothing resolves times later, match while ctx.now is current
+    _replay_match(replay, &ctx, on_frame, userdata);
+#endif
+  }
+  _replay_match(replay, &ctx, on_frame, userdata);
+  return re;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file fifo_dyn.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "fifo_dyn.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// move the items to the front of a new buffer of new_len items
+static int _resize(fifo_dyn_t *dyn, size_t new_len) {
+  fifo_t *fifo = &dyn->fifo;
+  size_t type_len = fifo->type_len;
+  size_t len = fifo_len(fifo);
+  size_t start = fifo->index_start;
+  size_t first = fifo->fifo_len - start;
+  char *buffer;
+
+  assert(len < new_len);
+  buffer = (char *)malloc(new_len * type_len);
+  if (!buffer)
+    return -ENOMEM;
+  if (first > len)
+    first = len;
+  memcpy(buffer, (char *)fifo->buffer + start * type_len, first * type_len);
+  memcpy(buffer + first * type_len, fifo->buffer, (len - first) * type_len);
+  free(fifo->buffer);
+  fifo->buffer = buffer;
+  fifo->fifo_len = new_len;
+  fifo->index_start = 0;
+  fifo->index_end = len;
+  return 0;
+}
+
+int fifo_dyn_init(fifo_dyn_t *dyn, size_t type_len, size_t min_len,
+                  size_t max_len, bool shrink) {
+  assert(dyn);
+  assert(type_len);
+  assert(min_len >= 2 && !(min_len & (min_len - 1)));
+  assert(max_len >= min_len && !(max_len & (max_len - 1)));
+
+  dyn->fifo.buffer = malloc(min_len * type_len);
+  if (!dyn->fifo.buffer)
+    return -ENOMEM;
+  dyn->fifo.fifo_len = min_len;
+  dyn->fifo.type_len = type_len;
+  dyn->fifo.index_start = dyn->fifo.index_end = 0;
+  dyn->min_len = min_len;
+  dyn->max_len = max_len;
+  dyn->shrink = shrink;
+  dyn->grows = dyn->shrinks = 0;
+  return 0;
+}
+
+void fifo_dyn_deinit(fifo_dyn_t *dyn) {
+  assert(dyn);
+  free(dyn->fifo.buffer);
+  dyn->fifo.buffer = NULL;
+  dyn->fifo.index_start = dyn->fifo.index_end = 0;
+}
+
+int fifo_dyn_grow(fifo_dyn_t *dyn, size_t num) {
+  size_t need, new_len;
+  int re;
+  assert(dyn);
+
+  need = fifo_len(&dyn->fifo) + num;
+  new_len = dyn->fifo.fifo_len;
+  if (need <= new_len - 1)
+    return 0;
+  // one resize straight to the final size
+  while (new_len - 1 < need && new_len < dyn->max_len)
+    new_len <<= 1;
+  if (new_len != dyn->fifo.fifo_len) {
+    re = _resize(dyn, new_len);
+    if (re)
+      return re;
+    dyn->grows++;
+  }
+  return need <= new_len - 1 ? 0 : -ENOSPC;
+}
+
+void fifo_dyn_shrink(fifo_dyn_t *dyn) {
+  size_t len, new_len;
+  assert(dyn);
+
+  len = fifo_len(&dyn->fifo);
+  new_len = dyn->fifo.fifo_len;
+  // stop at a quarter, a half full fifo would grow again on the next burst
+  while (new_len > dyn->min_len && len < new_len / 4)
+    new_len >>= 1;
+  // keep the larger buffer if there is no memory for the smaller one
+  if (new_len != dyn->fifo.fifo_len && !_resize(dyn, new_len))
+    dyn->shrinks++;
+}
+
+size_t fifo_dyn_push(fifo_dyn_t *dyn, const void *data, size_t num) {
+  size_t space;
+  assert(dyn);
+  assert(data);
+
+  fifo_dyn_grow(dyn, num);
+  space = fifo_capacity(&dyn->fifo) - fifo_len(&dyn->fifo);
+  if (num > space)
+    num = space;
+  fifo_push(&dyn->fifo, data, num);
+  return num;
+}
+
+size_t fifo_dyn_pop(fifo_dyn_t *dyn, void *data, size_t num) {
+  size_t len;
+  assert(dyn);
+  assert(data);
+
+  len = fifo_len(&dyn->fifo);
+  if (num > len)
+    num = len;
+  fifo_pop(&dyn->fifo, data, num);
+  if (dyn->shrink)
+    fifo_dyn_shrink(dyn);
+  return num;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file fifo_spill.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#define _GNU_SOURCE
+#include "fifo_spill.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static int _spill_open(fifo_spill_t *spill) {
+  char path[PATH_MAX];
+
+  snprintf(path, sizeof(path), "%s/fifo_spill_XXXXXX", spill->dir);
+  spill->fd = mkostemp(path, O_CLOEXEC);
+  if (spill->fd < 0)
+    return -1;
+  // the file lives as long as the descriptor
+  unlink(path);
+  return 0;
+}
+
+static char *_seg_map(fifo_spill_t *spill, fifo_spill_seg_t *seg) {
+  void *base = mmap(NULL, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    spill->fd, seg->offset);
+  return base == MAP_FAILED ? NULL : (char *)base;
+}
+
+static fifo_spill_seg_t *_seg_new(fifo_spill_t *spill) {
+  uint64_t page = sysconf(_SC_PAGESIZE);
+  fifo_spill_seg_t *seg;
+  int re;
+
+  if (spill->fd < 0 && _spill_open(spill))
+    goto fatal1;
+  seg = (fifo_spill_seg_t *)malloc(sizeof(*seg));
+  if (!seg)
+    goto fatal1;
+  seg->offset = spill->file_end;
+  seg->size = spill->seg_size;
+  // sparse growth, drained segments are punched out again
+  if (ftruncate(spill->fd, seg->offset + seg->size))
+    goto fatal2;
+  spill->wbase = _seg_map(spill, seg);
+  if (!spill->wbase)
+    goto fatal2;
+  spill->file_end = (seg->offset + seg->size + page - 1) & ~(page - 1);
+  seg->next = NULL;
+  seg->written = seg->read = 0;
+  return seg;
+fatal2:
+  re = errno;
+  free(seg);
+  errno = re;
+fatal1:
+  return NULL;
+}
+
+static void _seg_free(fifo_spill_t *spill, fifo_spill_seg_t *seg) {
+  if (seg == &spill->stub)
+    return;
+  free(seg);
+}
+
+void fifo_spill_init(fifo_spill_t *spill, fifo_t *fifo, const char *dir,
+                     size_t high, size_t seg_size) {
+  assert(spill);
+  assert(fifo);
+  assert(dir);
+  assert(high && high <= fifo_capacity(fifo));
+  assert(seg_size >= fifo->type_len);
+
+  spill->fifo = fifo;
+  spill->dir = dir;
+  spill->high = high;
+  spill->seg_size = seg_size - seg_size % fifo->type_len;
+  spill->fd = -1;
+  memset(&spill->stub, 0, sizeof(spill->stub));
+  spill->tail = spill->head = &spill->stub;
+  spill->wbase = spill->rbase = NULL;
+  spill->file_end = 0;
+  spill->spilling = false;
+  spill->spilled = 0;
+  spill->spill_items = 0;
+}
+
+void fifo_spill_deinit(fifo_spill_t *spill) {
+  fifo_spill_seg_t *seg, *next;
+  assert(spill);
+  if (spill->wbase)
+    munmap(spill->wbase, spill->tail->size);
+  if (spill->rbase)
+    munmap(spill->rbase, spill->head->size);
+  for (seg = spill->head; seg; seg = next) {
+    next = seg->next;
+    _seg_free(spill, seg);
+  }
+  if (spill->fd >= 0)
+    close(spill->fd);
+  spill->fd = -1;
+  spill->wbase = spill->rbase = NULL;
+  spill->file_end = 0;
+  spill->tail = spill->head = &spill->stub;
+  spill->stub.next = NULL;
+  spill->spill_items = 0;
+}
+
+// append up to num items to the spill, returns items written
+static size_t _spill_write(fifo_spill_t *spill, const char *data,
+                           size_t num) {
+  size_t type_len = spill->fifo->type_len;
+  fifo_spill_seg_t *tail = spill->tail;
+  char *wbase = spill->wbase;
+  size_t n;
+
+  if (tail->written == tail->size) {
+    fifo_spill_seg_t *seg = _seg_new(spill);
+    if (!seg)
+      return 0;
+    if (wbase) {
+      // start writeback now instead of piling up dirty pages, the
+      // consumer maps the segment again when it gets there
+      sync_file_range(spill->fd, tail->offset, tail->size,
+                      SYNC_FILE_RANGE_WRITE);
+      munmap(wbase, tail->size);
+    }
+    // the consumer may free tail from now on
+    __atomic_store_n(&tail->next, seg, __ATOMIC_RELEASE);
+    spill->tail = tail = seg;
+    wbase = spill->wbase;
+  }
+  n = (tail->size - tail->written) / type_len;
+  if (n > num)
+    n = num;
+  memcpy(wbase + tail->written, data, n * type_len);
+  __atomic_store_n(&tail->written, tail->written + n * type_len,
+                   __ATOMIC_RELEASE);
+  __atomic_add_fetch(&spill->spill_items, n, __ATOMIC_RELEASE);
+  spill->spilled += n;
+  return n;
+}
+
+size_t fifo_spill_push(fifo_spill_t *spill, const void *data, size_t num) {
+  const char *p = (const char *)data;
+  size_t type_len, done = 0;
+  assert(spill);
+  assert(data || !num);
+
+  type_len = spill->fifo->type_len;
+  while (done < num) {
+    size_t n, len;
+    // once spilling, the ring is used again only after the consumer
+    // drained the spill
+    if (spill->spilling &&
+        __atomic_load_n(&spill->spill_items, __ATOMIC_ACQUIRE))
+      goto spill;
+    len = fifo_len(spill->fifo);
+    n = len < spill->high ? spill->high - len : 0;
+    spill->spilling = !n;
+    if (!n)
+      goto spill;
+    if (n > num - done)
+      n = num - done;
+    fifo_push(spill->fifo, p + done * type_len, n);
+    done += n;
+    continue;
+  spill:
+    n = _spill_write(spill, p + done * type_len, num - done);
+    if (!n)
+      break;
+    done += n;
+  }
+  return done;
+}
+
+// read up to num items from the spill, returns items read
+static size_t _spill_read(fifo_spill_t *spill, char *data, size_t num) {
+  size_t type_len = spill->fifo->type_len;
+  fifo_spill_seg_t *head = spill->head;
+  size_t n, written;
+
+  written = __atomic_load_n(&head->written, __ATOMIC_ACQUIRE);
+  while (head->read == written) {
+    fifo_spill_seg_t *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if (!next)
+      return 0;
+    // the producer moved on, head is complete and read
+    if (spill->rbase) {
+      munmap(spill->rbase, head->size);
+      spill->rbase = NULL;
+      fallocate(spill->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                head->offset, head->size);
+    }
+    spill->head = next;
+    _seg_free(spill, head);
+    head = next;
+    written = __atomic_load_n(&head->written, __ATOMIC_ACQUIRE);
+  }
+  if (!spill->rbase) {
+    spill->rbase = _seg_map(spill, head);
+    if (!spill->rbase)
+      return 0;
+  }
+  n = (written - head->read) / type_len;
+  if (n > num)
+    n = num;
+  memcpy(data, spill->rbase + head->read, n * type_len);
+  head->read += n * type_len;
+  __atomic_sub_fetch(&spill->spill_items, n, __ATOMIC_RELEASE);
+  return n;
+}
+
+size_t fifo_spill_pop(fifo_spill_t *spill, void *data, size_t num) {
+  char *p = (char *)data;
+  size_t type_len, n, done = 0;
+  assert(spill);
+  assert(data || !num);
+
+  type_len = spill->fifo->type_len;
+  // the ring holds the older items
+  n = fifo_len(spill->fifo);
+  if (n) {
+    if (n > num)
+      n = num;
+    fifo_pop(spill->fifo, p, n);
+    done = n;
+  }
+  while (done < num && !fifo_len(spill->fifo) &&
+         __atomic_load_n(&spill->spill_items, __ATOMIC_ACQUIRE)) {
+    n = _spill_read(spill, p + done * type_len, num - done);
+    if (!n)
+      break;
+    done += n;
+  }
+  return done;
+}
+
+size_t fifo_spill_len(fifo_spill_t *spill) {
+  assert(spill);
+  return fifo_len(spill->fifo) +
+         __atomic_load_n(&spill->spill_items, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file frame_dispatch.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "frame_dispatch.h"
+#include <assert.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// spins on an empty queue before a worker goes to sleep
+#define DISPATCH_SPIN 64
+
+static void _worker_wake(frame_dispatch_worker_t *worker) {
+  uint64_t one = 1;
+  if (write(worker->wake_fd, &one, sizeof(one)) < 0)
+    assert(errno == EAGAIN);
+}
+
+static void _worker_sleep(frame_dispatch_worker_t *worker) {
+  uint64_t n;
+  // announce before the last look, frame_dispatch_post checks the flag
+  // after its push, one of the two sees the other
+  __atomic_store_n(&worker->sleeping, true, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (!fifo_len(&worker->queue) &&
+      !__atomic_load_n(&worker->owner->stop, __ATOMIC_SEQ_CST)) {
+    if (read(worker->wake_fd, &n, sizeof(n)) < 0)
+      assert(errno == EINTR);
+  }
+  __atomic_store_n(&worker->sleeping, false, __ATOMIC_RELAXED);
+}
+
+static void *_worker_run(void *arg) {
+  frame_dispatch_worker_t *worker = (frame_dispatch_worker_t *)arg;
+  frame_dispatch_t *dispatch = worker->owner;
+  unsigned index = worker - dispatch->workers;
+  frame_dispatch_item_t item;
+  int idle = 0;
+
+  for (;;) {
+    if (fifo_len(&worker->queue)) {
+      fifo_pop(&worker->queue, &item, 1);
+      dispatch->fn(index, item.key, item.frame, dispatch->userdata);
+      frame_unref(item.frame);
+      __atomic_store_n(&worker->handled, worker->handled + 1,
+                       __ATOMIC_RELAXED);
+      idle = 0;
+    } else if (__atomic_load_n(&dispatch->stop, __ATOMIC_ACQUIRE)) {
+      // stop is set after the last post, an empty queue is final
+      if (!fifo_len(&worker->queue))
+        break;
+    } else if (++idle < DISPATCH_SPIN) {
+      continue;
+    } else {
+      _worker_sleep(worker);
+      idle = 0;
+    }
+  }
+  return NULL;
+}
+
+int frame_dispatch_init(frame_dispatch_t *dispatch,
+                        frame_dispatch_worker_t *workers, unsigned count,
+                        frame_dispatch_item_t *buffer, size_t queue_len,
+                        frame_dispatch_fn_t fn, void *userdata) {
+  unsigned i;
+  int re;
+  assert(dispatch);
+  assert(workers && count);
+  assert(buffer);
+  assert(queue_len >= 2 && !(queue_len & (queue_len - 1)));
+  assert(fn);
+
+  dispatch->workers = workers;
+  dispatch->count = count;
+  dispatch->fn = fn;
+  dispatch->userdata = userdata;
+  dispatch->stop = false;
+  for (i = 0; i < count; i++) {
+    frame_dispatch_worker_t *w = &workers[i];
+    w->owner = dispatch;
+    w->queue.fifo_len = queue_len;
+    w->queue.type_len = sizeof(frame_dispatch_item_t);
+    w->queue.index_start = w->queue.index_end = 0;
+    w->queue.buffer = buffer + i * queue_len;
+    w->sleeping = false;
+    w->posted = w->rejected = w->handled = 0;
+    w->max_depth = 0;
+    w->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (w->wake_fd < 0) {
+      re = -errno;
+      goto fatal1;
+    }
+    re = -pthread_create(&w->thread, NULL, _worker_run, w);
+    if (re)
+      goto fatal2;
+  }
+  return 0;
+fatal2:
+  close(workers[i].wake_fd);
+fatal1:
+  // workers before i are running, let them exit
+  dispatch->count = i;
+  frame_dispatch_deinit(dispatch);
+  return re;
+}
+
+unsigned frame_dispatch_worker(const frame_dispatch_t *dispatch,
+                               uint32_t key) {
+  uint32_t hash;
+  assert(dispatch);
+  // fibonacci hashing: the high bits of the product depend on every key
+  // bit, scale them to count instead of keeping the low bits
+  hash = key * 2654435769u;
+  return (unsigned)(((uint64_t)hash * dispatch->count) >> 32);
+}
+
+int frame_dispatch_post(frame_dispatch_t *dispatch, uint32_t key,
+                        frame_t *frame) {
+  frame_dispatch_worker_t *w;
+  frame_dispatch_item_t item = {frame, key};
+  size_t depth;
+  assert(dispatch);
+  assert(frame);
+
+  w = &dispatch->workers[frame_dispatch_worker(dispatch, key)];
+  if (fifo_full(&w->queue)) {
+    __atomic_store_n(&w->rejected, w->rejected + 1, __ATOMIC_RELAXED);
+    return -EAGAIN;
+  }
+  fifo_push(&w->queue, &item, 1);
+  depth = fifo_len(&w->queue);
+  if (depth > w->max_depth)
+    __atomic_store_n(&w->max_depth, depth, __ATOMIC_RELAXED);
+  __atomic_store_n(&w->posted, w->posted + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&w->sleeping, __ATOMIC_RELAXED))
+    _worker_wake(w);
+  return 0;
+}
+
+void frame_dispatch_stats(frame_dispatch_t *dispatch, unsigned worker,
+                          frame_dispatch_stats_t *stats) {
+  frame_dispatch_worker_t *w;
+  assert(dispatch);
+  assert(worker < dispatch->count);
+  assert(stats);
+
+  w = &dispatch->workers[worker];
+  stats->depth = fifo_len(&w->queue);
+  stats->max_depth = __atomic_load_n(&w->max_depth, __ATOMIC_RELAXED);
+  stats->posted = __atomic_load_n(&w->posted, __ATOMIC_RELAXED);
+  stats->rejected = __atomic_load_n(&w->rejected, __ATOMIC_RELAXED);
+  stats->handled = __atomic_load_n(&w->handled, __ATOMIC_RELAXED);
+}
+
+void frame_dispatch_deinit(frame_dispatch_t *dispatch) {
+  assert(dispatch);
+  __atomic_store_n(&dispatch->stop, true, __ATOMIC_SEQ_CST);
+  for (unsigned i = 0; i < dispatch->count; i++) {
+    _worker_wake(&dispatch->workers[i]);
+    pthread_join(dispatch->workers[i].thread, NULL);
+    close(dispatch->workers[i].wake_fd);
+  }
+}
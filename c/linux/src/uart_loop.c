@@ -0,0 +1,432 @@
+/**
+ * @file uart_loop.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "uart_loop.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static inline uart_loop_port_t *to_port(void *data) {
+  return (uart_loop_port_t *)data;
+}
+
+static void _mark_dirty(uart_loop_port_t *port) {
+  // ports being processed are flushed and re-armed on the way out
+  if (port->dirty || port->busy || !port->loop)
+    return;
+  port->dirty = true;
+  port->next_dirty = port->loop->dirty;
+  port->loop->dirty = port;
+}
+
+static void loop_rx_async(char *ch, void *data) {
+  uart_loop_port_t *port = to_port(data);
+  port->rx_ptr = ch;
+  _mark_dirty(port);
+}
+
+static void loop_rx_async_abort(void *data) { to_port(data)->rx_ptr = NULL; }
+
+static void loop_tx_async(const char *ch, void *data) {
+  uart_loop_port_t *port = to_port(data);
+  assert(port->tx_tail < sizeof(port->tx_buf));
+  port->tx_buf[port->tx_tail++] = *ch;
+  port->tx_busy = true;
+  _mark_dirty(port);
+}
+
+static void loop_tx_async_abort(void *data) { to_port(data)->tx_busy = false; }
+
+static const uart_io_t uart_loop_io = {
+    .uart_rx_async = loop_rx_async,
+    .uart_rx_async_abort = loop_rx_async_abort,
+    .uart_tx_async = loop_tx_async,
+    .uart_tx_async_abort = loop_tx_async_abort,
+};
+
+static size_t _rx_space(uart_loop_port_t *port) {
+  fifo_t *fifo = port->uart.rx_fifo;
+  size_t space;
+  if (!port->rx_ptr || port->uart.status != uart_status_rx)
+    return 0;
+  space = fifo_capacity(fifo) - fifo_len(fifo);
+#if UART_RX_FILTER
+  // held bytes are pushed along with the address byte
+  if (space <= uart_rx_held(&port->uart))
+    return 0;
+  space -= uart_rx_held(&port->uart);
+#endif
+  return space;
+}
+
+static void _port_match(uart_loop_port_t *port) {
+  fifo_t *fifo = port->uart.rx_fifo;
+
+  if (!port->match)
+    return;
+  while (fifo_len(fifo)) {
+    size_t len = fifo_len(fifo);
+    int re = protocal_find_frame(fifo, port->match, port->frame_buf,
+                                 port->frame_size);
+    if (re > 0 && port->on_frame)
+      port->on_frame(port, port->frame_buf, re, port->userdata);
+    else if (re <= 0 && fifo_len(fifo) == len)
+      break;
+  }
+#if UART_UTILS_STATS
+  uart_stats_update(&port->uart);
+#endif
+}
+
+static void _port_read(uart_loop_port_t *port) {
+  char chunk[UART_LOOP_CHUNK_SIZE];
+  size_t space;
+
+  while ((space = _rx_space(port)) != 0) {
+    ssize_t n = read(port->fd, chunk, space < sizeof(chunk) ? space
+                                                             : sizeof(chunk));
+    if (n <= 0) {
+      if (n == 0 || (errno != EAGAIN && errno != EINTR))
+        port->closed = true;
+      if (n == 0 || errno != EINTR)
+        break;
+      continue;
+    }
+#if UART_RX_MARKS
+    // one timestamp per chunk
+    if (port->uart.rx_marks)
+      uart_rx_mark(&port->uart, utils_clock_now());
+#endif
+    for (ssize_t i = 0; i < n; i++) {
+      // rx_async re-arms rx_ptr from inside uart_isr_handle_rx, an
+      // overflow aborts rx and the rest of the chunk is lost
+      char *slot = port->rx_ptr;
+      if (!slot || port->uart.status != uart_status_rx)
+        break;
+      port->rx_ptr = NULL;
+      *slot = chunk[i];
+      uart_isr_handle_rx(&port->uart);
+    }
+    _port_match(port);
+  }
+}
+
+static void _port_flush(uart_loop_port_t *port) {
+  while (!port->closed) {
+    if (port->tx_head) {
+      memmove(port->tx_buf, port->tx_buf + port->tx_head,
+              port->tx_tail - port->tx_head);
+      port->tx_tail -= port->tx_head;
+      port->tx_head = 0;
+    }
+    // complete in-flight bytes, keep one slot for the next uart_enable_tx
+    while (port->tx_busy && port->tx_tail + 1 < sizeof(port->tx_buf) &&
+           port->uart.status == uart_status_tx) {
+      port->tx_busy = false;
+      uart_isr_handle_tx(&port->uart);
+    }
+    if (!port->tx_tail)
+      break;
+
+    ssize_t n = write(port->fd, port->tx_buf, port->tx_tail);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN)
+        port->closed = true;
+      break;
+    }
+    port->tx_head = n;
+    if (port->tx_head != port->tx_tail)
+      break;
+  }
+}
+
+static void _port_update_events(uart_loop_port_t *port) {
+  struct epoll_event ev;
+  unsigned events = 0;
+
+  if (!port->polled)
+    return;
+  if (port->closed) {
+    // EPOLLHUP/EPOLLERR can't be masked, a registered fd would spin
+    epoll_ctl(port->loop->epfd, EPOLL_CTL_DEL, port->fd, NULL);
+    port->polled = false;
+    port->events = 0;
+    if (port->on_close)
+      port->on_close(port, port->close_userdata);
+    return;
+  }
+  if (_rx_space(port))
+    events |= EPOLLIN;
+  if (port->tx_tail)
+    events |= EPOLLOUT;
+  if (events == port->events)
+    return;
+  ev.events = events;
+  ev.data.ptr = port;
+  epoll_ctl(port->loop->epfd, EPOLL_CTL_MOD, port->fd, &ev);
+  port->events = events;
+}
+
+static void _port_process(uart_loop_port_t *port) {
+  port->busy = true;
+  _port_read(port);
+  _port_flush(port);
+  port->busy = false;
+  _port_update_events(port);
+}
+
+static int _loop_process_dirty(uart_loop_t *loop) {
+  int num = 0;
+  while (loop->dirty) {
+    uart_loop_port_t *port = loop->dirty;
+    loop->dirty = port->next_dirty;
+    port->dirty = false;
+    _port_process(port);
+    num++;
+  }
+  return num;
+}
+
+static int _loop_run_tasks(uart_loop_t *loop) {
+  uart_loop_task_t *task, *order = NULL;
+  int num = 0;
+
+  task = __atomic_exchange_n(&loop->tasks, NULL, __ATOMIC_ACQUIRE);
+  // run in post order
+  while (task) {
+    uart_loop_task_t *next = task->next;
+    task->next = order;
+    order = task;
+    task = next;
+  }
+  while (order) {
+    task = order;
+    order = order->next;
+    task->fn(task);
+    num++;
+  }
+  return num;
+}
+
+int uart_loop_init(uart_loop_t *loop) {
+  struct epoll_event ev;
+  assert(loop);
+
+  loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (loop->epfd < 0)
+    goto fatal1;
+  loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (loop->wake_fd < 0)
+    goto fatal2;
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wake_fd, &ev))
+    goto fatal3;
+  loop->stop = false;
+  loop->started = false;
+  loop->dirty = NULL;
+  loop->tasks = NULL;
+  loop->port_num = 0;
+  return 0;
+fatal3:
+  close(loop->wake_fd);
+fatal2:
+  close(loop->epfd);
+fatal1:
+  return -errno;
+}
+
+void uart_loop_deinit(uart_loop_t *loop) {
+  assert(loop);
+  uart_loop_stop(loop);
+  close(loop->wake_fd);
+  close(loop->epfd);
+}
+
+int uart_loop_add(uart_loop_t *loop, uart_loop_port_t *port, int fd,
+                  fifo_t *rx_fifo, fifo_t *tx_fifo) {
+  struct epoll_event ev;
+  int flags;
+  assert(loop);
+  assert(port);
+
+  flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK))
+    return -errno;
+
+  port->loop = loop;
+  port->fd = fd;
+  port->rx_ptr = NULL;
+  port->tx_busy = false;
+  port->dirty = false;
+  port->busy = false;
+  port->closed = false;
+  port->polled = false;
+  port->events = 0;
+  port->tx_head = port->tx_tail = 0;
+  port->match = NULL;
+  port->on_frame = NULL;
+  port->userdata = NULL;
+  port->frame_buf = NULL;
+  port->frame_size = 0;
+  port->on_close = NULL;
+  port->close_userdata = NULL;
+  port->next_dirty = NULL;
+  uart_init(&port->uart, &uart_loop_io, port, rx_fifo, tx_fifo);
+
+  ev.events = 0;
+  ev.data.ptr = port;
+  if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev))
+    return -errno;
+  port->polled = true;
+  loop->port_num++;
+  return 0;
+}
+
+void uart_loop_remove(uart_loop_port_t *port) {
+  uart_loop_t *loop;
+  uart_loop_port_t **pp;
+  assert(port);
+
+  loop = port->loop;
+  if (!loop)
+    return;
+  for (pp = &loop->dirty; *pp; pp = &(*pp)->next_dirty) {
+    if (*pp == port) {
+      *pp = port->next_dirty;
+      break;
+    }
+  }
+  if (port->polled)
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, port->fd, NULL);
+  port->polled = false;
+  loop->port_num--;
+  port->loop = NULL;
+  port->dirty = false;
+}
+
+void uart_loop_set_matcher(uart_loop_port_t *port, protocal_match_fn_t fn,
+                           char *buffer, size_t buff_size,
+                           uart_loop_frame_fn_t on_frame, void *userdata) {
+  assert(port);
+  assert(!fn || buffer);
+  port->match = fn;
+  port->frame_buf = buffer;
+  port->frame_size = buff_size;
+  port->on_frame = on_frame;
+  port->userdata = userdata;
+}
+
+void uart_loop_set_close(uart_loop_port_t *port, uart_loop_close_fn_t fn,
+                         void *userdata) {
+  assert(port);
+  port->on_close = fn;
+  port->close_userdata = userdata;
+}
+
+void uart_loop_update(uart_loop_port_t *port) {
+  assert(port);
+  _mark_dirty(port);
+}
+
+int uart_loop_run_once(uart_loop_t *loop, int timeout_ms) {
+  struct epoll_event events[UART_LOOP_MAX_EVENTS];
+  int n, num;
+  assert(loop);
+
+  // flush writes issued since the last iteration, don't sleep if it did work
+  num = _loop_run_tasks(loop);
+  num += _loop_process_dirty(loop);
+  n = epoll_wait(loop->epfd, events, UART_LOOP_MAX_EVENTS,
+                 num ? 0 : timeout_ms);
+  if (n < 0)
+    return errno == EINTR ? num : -errno;
+
+  for (int i = 0; i < n; i++) {
+    uart_loop_port_t *port = to_port(events[i].data.ptr);
+    if (!port) {
+      uint64_t cnt;
+      // stop flag is checked by the caller, tasks run below
+      (void)!read(loop->wake_fd, &cnt, sizeof(cnt));
+      continue;
+    }
+    if (events[i].events & (EPOLLERR | EPOLLHUP) &&
+        !(events[i].events & EPOLLIN))
+      port->closed = true;
+    _port_process(port);
+  }
+  num += _loop_run_tasks(loop);
+  return n + num + _loop_process_dirty(loop);
+}
+
+int uart_loop_run(uart_loop_t *loop) {
+  assert(loop);
+  while (!__atomic_load_n(&loop->stop, __ATOMIC_ACQUIRE)) {
+    int re = uart_loop_run_once(loop, -1);
+    if (re < 0)
+      return re;
+  }
+  return 0;
+}
+
+static void *_loop_thread(void *arg) {
+  uart_loop_run((uart_loop_t *)arg);
+  return NULL;
+}
+
+int uart_loop_start(uart_loop_t *loop) {
+  int re;
+  assert(loop);
+  assert(!loop->started);
+  __atomic_store_n(&loop->stop, false, __ATOMIC_RELEASE);
+  re = pthread_create(&loop->thread, NULL, _loop_thread, loop);
+  if (re)
+    return -re;
+  loop->started = true;
+  return 0;
+}
+
+static void _loop_wake(uart_loop_t *loop) {
+  uint64_t one = 1;
+  if (write(loop->wake_fd, &one, sizeof(one)) < 0)
+    assert(errno == EAGAIN);
+}
+
+void uart_loop_post(uart_loop_t *loop, uart_loop_task_t *task) {
+  uart_loop_task_t *head;
+  assert(loop);
+  assert(task && task->fn);
+
+  head = __atomic_load_n(&loop->tasks, __ATOMIC_RELAXED);
+  do {
+    task->next = head;
+  } while (!__atomic_compare_exchange_n(&loop->tasks, &head, task, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  // the first task of a batch wakes the loop
+  if (!head)
+    _loop_wake(loop);
+}
+
+void uart_loop_stop(uart_loop_t *loop) {
+  assert(loop);
+  __atomic_store_n(&loop->stop, true, __ATOMIC_RELEASE);
+  _loop_wake(loop);
+  if (loop->started) {
+    pthread_join(loop->thread, NULL);
+    loop->started = false;
+  }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file uart_mp.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "uart_mp.h"
+#include <assert.h>
+#include <sched.h>
+#include <string.h>
+
+// spins before yielding while an earlier writer publishes
+#define UART_MP_SPIN 64
+
+void uart_mp_init(uart_mp_t *mp, uart_t *inst, void (*kick_fn)(uart_mp_t *mp),
+                  void *userdata) {
+  assert(mp);
+  assert(inst);
+  assert(kick_fn);
+  assert(inst->tx_fifo->type_len == 1);
+  mp->inst = inst;
+  mp->reserve = inst->tx_fifo->index_end;
+  mp->kick = false;
+  mp->kick_fn = kick_fn;
+  mp->userdata = userdata;
+  mp->task.fn = NULL;
+  mp->task.next = NULL;
+}
+
+static void _loop_service(uart_loop_task_t *task) {
+  uart_mp_t *mp = (uart_mp_t *)((char *)task - offsetof(uart_mp_t, task));
+  uart_mp_service(mp);
+}
+
+static void _loop_kick(uart_mp_t *mp) {
+  uart_loop_port_t *port = (uart_loop_port_t *)mp->userdata;
+  uart_loop_post(port->loop, &mp->task);
+}
+
+void uart_mp_init_loop(uart_mp_t *mp, uart_loop_port_t *port) {
+  assert(port);
+  uart_mp_init(mp, &port->uart, _loop_kick, port);
+  mp->task.fn = _loop_service;
+}
+
+size_t uart_mp_write(uart_mp_t *mp, const char *c, size_t num) {
+  fifo_t *fifo;
+  size_t mask, start, end, head, tail;
+  char *buffer;
+  assert(mp);
+  assert(c);
+
+  fifo = mp->inst->tx_fifo;
+  mask = fifo->fifo_len - 1;
+  buffer = (char *)fifo->buffer;
+  if (!num || num > mask)
+    return 0;
+
+  // claim [start, end), head is loaded first so it never runs past start
+  do {
+    head = __atomic_load_n(&fifo->index_start, __ATOMIC_ACQUIRE);
+    start = __atomic_load_n(&mp->reserve, __ATOMIC_RELAXED);
+    if (mask - ((start - head) & mask) < num)
+      return 0;
+    end = (start + num) & mask;
+  } while (!__atomic_compare_exchange_n(&mp->reserve, &start, end, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  tail = fifo->fifo_len - start;
+  if (tail >= num) {
+    memcpy(buffer + start, c, num);
+  } else {
+    memcpy(buffer + start, c, tail);
+    memcpy(buffer, c + tail, num - tail);
+  }
+
+  // publish in claim order
+  for (int spin = 0;
+       __atomic_load_n(&fifo->index_end, __ATOMIC_ACQUIRE) != start; spin++) {
+    if (spin >= UART_MP_SPIN)
+      sched_yield();
+  }
+  __atomic_store_n(&fifo->index_end, end, __ATOMIC_RELEASE);
+
+  if (!__atomic_exchange_n(&mp->kick, true, __ATOMIC_SEQ_CST))
+    mp->kick_fn(mp);
+  return num;
+}
+
+void uart_mp_service(uart_mp_t *mp) {
+  assert(mp);
+  // frames published after this point kick again
+  __atomic_store_n(&mp->kick, false, __ATOMIC_SEQ_CST);
+  if (mp->inst->status != uart_status_tx)
+    uart_enable_tx(mp->inst);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file capture_utils.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "capture_utils.h"
+#include <assert.h>
+#include <string.h>
+
+void capture_init(capture_t *cap, char *buf, size_t size,
+                  capture_sink_fn_t sink, void *userdata, uint32_t tick_ns) {
+  capture_header_t header = {CAPTURE_MAGIC, CAPTURE_VERSION,
+                             sizeof(capture_header_t), tick_ns, 0};
+  assert(cap);
+  assert(buf && size > sizeof(header) + sizeof(capture_record_t));
+  assert(sink);
+
+  cap->sink = sink;
+  cap->userdata = userdata;
+  cap->buf = buf;
+  cap->size = size;
+  cap->open = false;
+  cap->merge_ticks = 0;
+  cap->dropped = 0;
+  cap->time_hi = 0;
+  cap->time_lost = false;
+  memcpy(buf, &header, sizeof(header));
+  cap->used = sizeof(header);
+}
+
+void capture_set_merge(capture_t *cap, utils_tick_t ticks) {
+  assert(cap);
+  cap->merge_ticks = ticks;
+}
+
+void capture_flush(capture_t *cap) {
+  size_t n;
+  assert(cap);
+  cap->open = false;
+  if (!cap->used)
+    return;
+  n = cap->sink(cap->userdata, cap->buf, cap->used);
+  if (n < cap->used) {
+    cap->dropped += cap->used - n;
+    cap->time_lost = true;
+  }
+  cap->used = 0;
+}
+
+// records are unaligned in buf, access them with memcpy
+static inline char *_record(capture_t *cap) { return cap->buf + cap->rec; }
+
+static bool _can_merge(capture_t *cap, uint8_t chan, capture_dir_t dir,
+                       utils_tick_t time) {
+  capture_record_t rec;
+  if (!cap->open)
+    return false;
+  memcpy(&rec, _record(cap), sizeof(rec));
+  return rec.chan == chan && rec.dir == dir && rec.len < UINT16_MAX &&
+         (utils_tick_t)(time - cap->last_time) <= cap->merge_ticks;
+}
+
+static void _put_time(capture_t *cap, utils_tick_t time, uint32_t hi) {
+  capture_record_t rec = {(uint32_t)time, sizeof(hi), capture_time, 0};
+  memcpy(cap->buf + cap->used, &rec, sizeof(rec));
+  memcpy(cap->buf + cap->used + sizeof(rec), &hi, sizeof(hi));
+  cap->used += sizeof(rec) + sizeof(hi);
+  cap->time_hi = hi;
+  cap->time_lost = false;
+}
+
+void capture_write(capture_t *cap, uint8_t chan, capture_dir_t dir,
+                   utils_tick_t time, const void *data, size_t len) {
+  const char *p = (const char *)data;
+  capture_record_t rec;
+  assert(cap);
+  assert(data || !len);
+
+  while (len) {
+    size_t n;
+    if (!_can_merge(cap, chan, dir, time) || cap->used == cap->size) {
+      uint32_t hi = (uint32_t)((uint64_t)time >> 32);
+      // room for a capture_time record as well
+      if (cap->size - cap->used <= 2 * sizeof(rec) + sizeof(hi))
+        capture_flush(cap);
+      if (hi != cap->time_hi || cap->time_lost)
+        _put_time(cap, time, hi);
+      rec.time = (uint32_t)time;
+      rec.len = 0;
+      rec.dir = dir;
+      rec.chan = chan;
+      cap->rec = cap->used;
+      memcpy(cap->buf + cap->used, &rec, sizeof(rec));
+      cap->used += sizeof(rec);
+      cap->open = true;
+    }
+    memcpy(&rec, _record(cap), sizeof(rec));
+    n = cap->size - cap->used;
+    if (n > len)
+      n = len;
+    if (n > (size_t)(UINT16_MAX - rec.len))
+      n = UINT16_MAX - rec.len;
+    memcpy(cap->buf + cap->used, p, n);
+    cap->used += n;
+    rec.len += n;
+    memcpy(_record(cap), &rec, sizeof(rec));
+    cap->last_time = time;
+    p += n;
+    len -= n;
+  }
+}
@@ -0,0 +1,23 @@
+/**
+ * @file clock_utils.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "clock_utils.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+
+__attribute__((weak)) utils_tick_t utils_clock_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (utils_tick_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+#else
+__attribute__((weak)) utils_tick_t utils_clock_now(void) { return 0; }
+#endif
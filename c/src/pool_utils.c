@@ -0,0 +1,94 @@
+/**
+ * @file pool_utils.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "pool_utils.h"
+#include <assert.h>
+#include <stdbool.h>
+
+#define POOL_NIL 0xffff
+
+static inline uint32_t _head(uint32_t old, uint16_t index) {
+  return ((old + 0x10000) & 0xffff0000) | index;
+}
+
+static void _push(frame_pool_t *pool, frame_t *frame) {
+  uint16_t index = frame - pool->frames;
+  uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+  // count first, so frame_alloc never takes what was not counted yet
+  __atomic_add_fetch(&pool->available, 1, __ATOMIC_RELAXED);
+  do {
+    __atomic_store_n(&frame->next, head & 0xffff, __ATOMIC_RELAXED);
+  } while (!__atomic_compare_exchange_n(&pool->head, &head,
+                                        _head(head, index), true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void frame_pool_init(frame_pool_t *pool, frame_t *frames, char *buffer,
+                     uint16_t count, size_t frame_size) {
+  assert(pool);
+  assert(frames && buffer);
+  assert(count && count <= FRAME_POOL_MAX);
+  assert(frame_size);
+
+  pool->frames = frames;
+  pool->frame_size = frame_size;
+  pool->count = count;
+  pool->head = POOL_NIL;
+  pool->available = 0;
+  // push in reverse, frames are handed out in address order
+  for (int i = count - 1; i >= 0; i--) {
+    frames[i].data = buffer + (size_t)i * frame_size;
+    frames[i].len = 0;
+    frames[i].pool = pool;
+    frames[i].refs = 0;
+    _push(pool, &frames[i]);
+  }
+}
+
+frame_t *frame_alloc(frame_pool_t *pool) {
+  uint32_t head, next;
+  frame_t *frame;
+  assert(pool);
+
+  head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+  do {
+    if ((head & 0xffff) == POOL_NIL)
+      return NULL;
+    frame = &pool->frames[head & 0xffff];
+    // may read a link that changed meanwhile, the tag fails the cas then
+    next = __atomic_load_n(&frame->next, __ATOMIC_RELAXED);
+  } while (!__atomic_compare_exchange_n(&pool->head, &head, _head(head, next),
+                                        true, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE));
+  __atomic_sub_fetch(&pool->available, 1, __ATOMIC_RELAXED);
+  frame->len = 0;
+  __atomic_store_n(&frame->refs, 1, __ATOMIC_RELAXED);
+  return frame;
+}
+
+frame_t *frame_ref(frame_t *frame) {
+  assert(frame);
+  assert(__atomic_load_n(&frame->refs, __ATOMIC_RELAXED));
+  __atomic_add_fetch(&frame->refs, 1, __ATOMIC_RELAXED);
+  return frame;
+}
+
+void frame_unref(frame_t *frame) {
+  assert(frame);
+  assert(__atomic_load_n(&frame->refs, __ATOMIC_RELAXED));
+  // consumers' reads of data happen before the frame is reused
+  if (__atomic_sub_fetch(&frame->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    _push(frame->pool, frame);
+}
+
+size_t frame_pool_available(frame_pool_t *pool) {
+  assert(pool);
+  return __atomic_load_n(&pool->available, __ATOMIC_RELAXED);
+}
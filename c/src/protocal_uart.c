@@ -0,0 +1,61 @@
+/**
+ * @file protocal_uart.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include <assert.h>
+#include <protocal_uart.h>
+
+#if UART_RX_MARKS
+void protocal_ts_init(protocal_ts_t *ts, fifo_t *marks) {
+  assert(ts);
+  assert(marks && marks->type_len == sizeof(uart_rx_mark_t));
+  ts->marks = marks;
+  ts->valid = false;
+}
+
+// move ts->cur up to the fifo head
+static void _ts_advance(fifo_t *fifo, protocal_ts_t *ts) {
+  size_t head = fifo->index_start;
+  size_t mask = fifo->fifo_len - 1;
+  uart_rx_mark_t mark;
+
+  while (fifo_len(ts->marks)) {
+    fifo_peek(ts->marks, 0, &mark);
+    // marks after the head point into the buffered bytes
+    size_t dist = (mark.index - head) & mask;
+    if (dist && dist < fifo_len(fifo))
+      break;
+    fifo_pop(ts->marks, &ts->cur, 1);
+    ts->valid = true;
+  }
+}
+
+int protocal_find_frame_ts(fifo_t *fifo, protocal_match_fn_t fn, void *buffer,
+                           size_t buff_size, protocal_ts_t *ts,
+                           utils_tick_t *time) {
+  int re;
+
+  assert(ts);
+  assert(time);
+  _ts_advance(fifo, ts);
+  re = protocal_find_frame(fifo, fn, buffer, buff_size);
+  if (re > 0 && ts->valid)
+    *time = ts->cur.time;
+  return re;
+}
+#endif
+
+size_t protocal_enc_end_uart(protocal_enc_t *enc, uart_t *inst) {
+  size_t n;
+  assert(enc);
+  assert(inst && enc->fifo == inst->tx_fifo);
+  n = protocal_enc_finish(enc);
+  uart_write_commit(inst, n);
+  return n;
+}
@@ -9,7 +9,10 @@
  *
  */
 #include <assert.h>
+#include <pool_utils.h>
 #include <protocal_utils.h>
+#include <stddef.h>
+#include <trace_utils.h>
 
 int protocal_find_frame(fifo_t *fifo, protocal_match_fn_t fn, void *buffer,
                         size_t buff_size) {
@@ -20,6 +23,7 @@ int protocal_find_frame(fifo_t *fifo, protocal_match_fn_t fn, void *buffer,
   if (!fifo_len(fifo)) {
     return 0;
   }
+  TRACE(trace_protocal_find_enter, fifo, fifo_len(fifo));
   re = fn(fifo);
 
   if (re < 0) {
@@ -27,10 +31,366 @@ int protocal_find_frame(fifo_t *fifo, protocal_match_fn_t fn, void *buffer,
     for (int i = 0; i < re; i++) {
       fifo_pop(fifo, buffer, 1);
     }
+    re = 0;
   } else if (buff_size >= re) {
     fifo_pop(fifo, buffer, re);
-    return re;
+  } else {
+    re = 0;
   }
 
-  return 0;
+  TRACE(trace_protocal_find_exit, fifo, re);
+  return re;
+}
+
+frame_t *protocal_find_frame_pool(fifo_t *fifo, protocal_match_fn_t fn,
+                                  frame_pool_t *pool) {
+  frame_t *frame = NULL;
+  int re;
+
+  assert(fifo && fifo->type_len == 1);
+  assert(pool);
+
+  if (!fifo_len(fifo)) {
+    return NULL;
+  }
+  TRACE(trace_protocal_find_enter, fifo, fifo_len(fifo));
+  re = fn(fifo);
+
+  if (re < 0) {
+    char c;
+    for (int i = 0; i < -re; i++) {
+      fifo_pop(fifo, &c, 1);
+    }
+  } else if (re > 0 && pool->frame_size >= (size_t)re) {
+    frame = frame_alloc(pool);
+    if (frame) {
+      fifo_pop(fifo, frame->data, re);
+      frame->len = re;
+    }
+  }
+
+  TRACE(trace_protocal_find_exit, fifo, frame ? re : 0);
+  return frame;
+}
+
+static inline protocal_stream_t *_stream(timer_node_t *node) {
+  return (protocal_stream_t *)((char *)node -
+                               offsetof(protocal_stream_t, timer));
+}
+
+static void _stream_expired(protocal_stream_t *stream, size_t num) {
+  TRACE(trace_protocal_expire, stream->fifo, num);
+  stream->expired++;
+  stream->dropped += num;
+  stream->partial = false;
+}
+
+static void _stream_drop(protocal_stream_t *stream, size_t num) {
+  char c;
+  for (size_t i = 0; i < num; i++)
+    fifo_pop(stream->fifo, &c, 1);
+  _stream_expired(stream, num);
+}
+
+// ticks until since + timeout, 0 if already passed
+static inline utils_tick_t _left(utils_tick_t since, utils_tick_t timeout,
+                                 utils_tick_t now) {
+  utils_tick_t elapsed = now - since;
+  return elapsed >= timeout ? 0 : timeout - elapsed;
+}
+
+static void _stream_arm(protocal_stream_t *stream) {
+  timer_wheel_t *wheel = stream->wheel;
+  utils_tick_t left, wait = 0;
+  bool armed = false;
+
+  if (stream->byte_timeout) {
+    wait = _left(stream->last_byte, stream->byte_timeout, wheel->now);
+    armed = true;
+  }
+  if (stream->frame_timeout) {
+    left = _left(stream->frame_start, stream->frame_timeout, wheel->now);
+    if (!armed || left < wait)
+      wait = left;
+    armed = true;
+  }
+  if (armed)
+    timer_start(wheel, &stream->timer, wait);
+}
+
+// drop leading garbage, return the matcher result for the new head
+static int _stream_skip(protocal_stream_t *stream) {
+  fifo_t *fifo = stream->fifo;
+  int re = 0;
+  char c;
+
+  while (fifo_len(fifo) && (re = stream->fn(fifo)) < 0) {
+    for (int i = 0; i < -re && fifo_len(fifo); i++)
+      fifo_pop(fifo, &c, 1);
+  }
+  return re;
+}
+
+// match the rest right away: a new partial frame gets its own timeout, a
+// complete one waits for protocal_stream_find
+static void _stream_resync(protocal_stream_t *stream, utils_tick_t now) {
+  int re = _stream_skip(stream);
+  if (fifo_len(stream->fifo) && !re) {
+    stream->partial = true;
+    stream->frame_start = now;
+    _stream_arm(stream);
+  }
+}
+
+static void _stream_expire(timer_node_t *node) {
+  protocal_stream_t *stream = _stream(node);
+  utils_tick_t now = stream->wheel->now;
+  size_t len = fifo_len(stream->fifo);
+
+  if (!stream->partial)
+    return;
+  if (len > stream->seen) {
+    // bytes came in since the last look, the line is not quiet
+    stream->last_byte = now;
+    stream->seen = len;
+  }
+  if (stream->byte_timeout &&
+      !_left(stream->last_byte, stream->byte_timeout, now)) {
+    // the line is quiet, so no frame starting in the buffer can complete,
+    // but whole frames queued behind the stale head are kept
+    char c;
+    do
+      fifo_pop(stream->fifo, &c, 1);
+    while (fifo_len(stream->fifo) && !_stream_skip(stream));
+    _stream_expired(stream, len - fifo_len(stream->fifo));
+  } else if (stream->frame_timeout &&
+             !_left(stream->frame_start, stream->frame_timeout, now)) {
+    _stream_drop(stream, 1);
+    _stream_resync(stream, now);
+  } else {
+    _stream_arm(stream);
+    return;
+  }
+  stream->seen = fifo_len(stream->fifo);
+}
+
+void protocal_stream_init(protocal_stream_t *stream, fifo_t *fifo,
+                          protocal_match_fn_t fn, timer_wheel_t *wheel,
+                          utils_tick_t byte_timeout,
+                          utils_tick_t frame_timeout) {
+  assert(stream);
+  assert(fifo && fifo->type_len == 1);
+  assert(fn);
+  assert(wheel);
+  assert(byte_timeout < UTILS_TICK_MAX / 2);
+  assert(frame_timeout < UTILS_TICK_MAX / 2);
+
+  stream->fifo = fifo;
+  stream->fn = fn;
+  stream->wheel = wheel;
+  stream->byte_timeout = byte_timeout;
+  stream->frame_timeout = frame_timeout;
+  timer_init(&stream->timer, _stream_expire);
+  stream->seen = 0;
+  stream->last_byte = stream->frame_start = wheel->now;
+  stream->partial = false;
+  stream->expired = 0;
+  stream->dropped = 0;
+}
+
+int protocal_stream_find(protocal_stream_t *stream, void *buffer,
+                         size_t buff_size) {
+  utils_tick_t now;
+  size_t len;
+  int re;
+
+  assert(stream);
+  now = stream->wheel->now;
+  len = fifo_len(stream->fifo);
+  if (len > stream->seen)
+    stream->last_byte = now;
+  re = protocal_find_frame(stream->fifo, stream->fn, buffer, buff_size);
+  if (!re && len && fifo_len(stream->fifo) == len) {
+    // matcher waits for more bytes
+    if (!stream->partial) {
+      stream->partial = true;
+      stream->frame_start = now;
+    }
+    _stream_arm(stream);
+  } else if (stream->partial) {
+    stream->partial = false;
+    timer_cancel(&stream->timer);
+  }
+  stream->seen = fifo_len(stream->fifo);
+  return re;
+}
+
+void protocal_stream_deinit(protocal_stream_t *stream) {
+  assert(stream);
+  timer_cancel(&stream->timer);
+  stream->partial = false;
+}
+
+#define SLIP_END 0xC0
+#define SLIP_ESC 0xDB
+#define SLIP_ESC_END 0xDC
+#define SLIP_ESC_ESC 0xDD
+
+size_t protocal_enc_size(protocal_enc_type_t type, size_t max_payload) {
+  switch (type) {
+  case protocal_enc_cobs:
+    // code byte per 254 bytes, first code and delimiter
+    return max_payload + max_payload / 254 + 2;
+  case protocal_enc_slip:
+    return 2 * max_payload + 2;
+  default:
+    return max_payload + 4;
+  }
+}
+
+static inline uint16_t _crc16_byte(uint16_t crc, uint8_t c) {
+  uint16_t x = (uint8_t)(crc >> 8) ^ c;
+  x ^= x >> 4;
+  return (crc << 8) ^ (x << 12) ^ (x << 5) ^ x;
+}
+
+uint16_t protocal_crc16(uint16_t crc, const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  assert(data || !len);
+  while (len--)
+    crc = _crc16_byte(crc, *p++);
+  return crc;
+}
+
+// frame byte at offset pos, the fifo is only written, never read
+static inline uint8_t *_enc_at(protocal_enc_t *enc, size_t pos) {
+  fifo_t *fifo = enc->fifo;
+  return (uint8_t *)fifo->buffer +
+         ((enc->start + pos) & (fifo->fifo_len - 1));
+}
+
+static inline void _enc_put(protocal_enc_t *enc, uint8_t c) {
+  assert(enc->pos < enc->room);
+  *_enc_at(enc, enc->pos++) = c;
+}
+
+// cobs: fill in the open code byte and open the next one
+static inline void _enc_cobs_block(protocal_enc_t *enc) {
+  *_enc_at(enc, enc->code) = enc->pos - enc->code;
+  enc->code = enc->pos++;
+}
+
+bool protocal_enc_begin(protocal_enc_t *enc, fifo_t *fifo,
+                        protocal_enc_type_t type, size_t max_payload) {
+  size_t room = protocal_enc_size(type, max_payload);
+  assert(enc);
+  assert(fifo && fifo->type_len == 1);
+
+  if (type == protocal_enc_len_crc && max_payload > UINT16_MAX)
+    return false;
+  if (fifo_capacity(fifo) - fifo_len(fifo) < room)
+    return false;
+  enc->fifo = fifo;
+  enc->type = type;
+  enc->start = fifo->index_end;
+  enc->room = room;
+  enc->len = 0;
+  enc->max = max_payload;
+  enc->crc = 0xFFFF;
+  switch (type) {
+  case protocal_enc_cobs:
+    enc->code = 0;
+    enc->pos = 1;
+    break;
+  case protocal_enc_slip:
+    // flush line noise the receiver may have collected
+    enc->pos = 0;
+    _enc_put(enc, SLIP_END);
+    break;
+  default:
+    // length goes in at the end
+    enc->pos = 2;
+    break;
+  }
+  return true;
+}
+
+size_t protocal_enc_write(protocal_enc_t *enc, const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  size_t n;
+  assert(enc);
+  assert(data || !len);
+
+  // the room reserved by protocal_enc_begin only covers max payload bytes
+  if (len > enc->max - enc->len)
+    len = enc->max - enc->len;
+  n = len;
+  enc->len += len;
+  switch (enc->type) {
+  case protocal_enc_cobs:
+    while (len--) {
+      uint8_t c = *p++;
+      if (enc->pos - enc->code == 0xFF)
+        _enc_cobs_block(enc);
+      if (c)
+        _enc_put(enc, c);
+      else
+        _enc_cobs_block(enc);
+    }
+    break;
+  case protocal_enc_slip:
+    while (len--) {
+      uint8_t c = *p++;
+      if (c == SLIP_END) {
+        _enc_put(enc, SLIP_ESC);
+        _enc_put(enc, SLIP_ESC_END);
+      } else if (c == SLIP_ESC) {
+        _enc_put(enc, SLIP_ESC);
+        _enc_put(enc, SLIP_ESC_ESC);
+      } else {
+        _enc_put(enc, c);
+      }
+    }
+    break;
+  default:
+    while (len--) {
+      uint8_t c = *p++;
+      enc->crc = _crc16_byte(enc->crc, c);
+      _enc_put(enc, c);
+    }
+    break;
+  }
+  return n;
+}
+
+size_t protocal_enc_finish(protocal_enc_t *enc) {
+  assert(enc);
+  switch (enc->type) {
+  case protocal_enc_cobs:
+    *_enc_at(enc, enc->code) = enc->pos - enc->code;
+    _enc_put(enc, 0);
+    break;
+  case protocal_enc_slip:
+    _enc_put(enc, SLIP_END);
+    break;
+  default:
+    assert(enc->len <= UINT16_MAX);
+    *_enc_at(enc, 0) = enc->len;
+    *_enc_at(enc, 1) = enc->len >> 8;
+    _enc_put(enc, enc->crc);
+    _enc_put(enc, enc->crc >> 8);
+    break;
+  }
+  return enc->pos;
+}
+
+size_t protocal_enc_end(protocal_enc_t *enc) {
+  size_t n = protocal_enc_finish(enc);
+  fifo_commit(enc->fifo, n);
+  return n;
+}
+
+void protocal_enc_abort(protocal_enc_t *enc) {
+  assert(enc);
+  enc->pos = 0;
 }
@@ -0,0 +1,114 @@
+/**
+ * @file timer_utils.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "timer_utils.h"
+#include <assert.h>
+
+// true if expire is at or before now, wrap around safe
+static inline bool _expired(utils_tick_t expire, utils_tick_t now) {
+  return (utils_tick_t)(now - expire) <= UTILS_TICK_MAX / 2;
+}
+
+static inline timer_node_t *_slot(timer_wheel_t *wheel, utils_tick_t t) {
+  return &wheel->slots[(t >> wheel->shift) & (wheel->slot_count - 1)];
+}
+
+static inline void _link(timer_node_t *head, timer_node_t *node) {
+  node->next = head;
+  node->prev = head->prev;
+  head->prev->next = node;
+  head->prev = node;
+}
+
+static inline void _unlink(timer_node_t *node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = node->prev = NULL;
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, timer_node_t *slots,
+                      size_t slot_count, unsigned shift, utils_tick_t now) {
+  assert(wheel);
+  assert(slots);
+  assert(slot_count && !(slot_count & (slot_count - 1)));
+  assert(shift < sizeof(utils_tick_t) * 8);
+
+  wheel->slots = slots;
+  wheel->slot_count = slot_count;
+  wheel->shift = shift;
+  wheel->now = now;
+  for (size_t i = 0; i < slot_count; i++)
+    slots[i].next = slots[i].prev = &slots[i];
+}
+
+void timer_init(timer_node_t *node, timer_fn_t fn) {
+  assert(node);
+  assert(fn);
+  node->next = node->prev = NULL;
+  node->fn = fn;
+}
+
+void timer_add(timer_wheel_t *wheel, timer_node_t *node, utils_tick_t expire) {
+  assert(wheel);
+  assert(node && node->fn);
+
+  if (timer_pending(node))
+    _unlink(node);
+  node->expire = expire;
+  // a slot already passed would only be seen after a full turn
+  _link(_slot(wheel, _expired(expire, wheel->now) ? wheel->now : expire),
+        node);
+}
+
+void timer_start(timer_wheel_t *wheel, timer_node_t *node,
+                 utils_tick_t timeout) {
+  assert(wheel);
+  assert(timeout < UTILS_TICK_MAX / 2);
+  timer_add(wheel, node, wheel->now + timeout);
+}
+
+void timer_cancel(timer_node_t *node) {
+  assert(node);
+  if (timer_pending(node))
+    _unlink(node);
+}
+
+size_t timer_wheel_advance(timer_wheel_t *wheel, utils_tick_t now) {
+  timer_node_t fired = {&fired, &fired, 0, NULL};
+  utils_tick_t t, steps;
+  size_t count = 0;
+  assert(wheel);
+
+  t = wheel->now >> wheel->shift;
+  steps = (now >> wheel->shift) - t;
+  if (steps >= wheel->slot_count)
+    steps = wheel->slot_count - 1;
+  // collect first, callbacks may add timers to the slots being walked
+  for (utils_tick_t i = 0; i <= steps; i++) {
+    timer_node_t *head = &wheel->slots[(t + i) & (wheel->slot_count - 1)];
+    timer_node_t *node = head->next;
+    while (node != head) {
+      timer_node_t *next = node->next;
+      if (_expired(node->expire, now)) {
+        _unlink(node);
+        _link(&fired, node);
+      }
+      node = next;
+    }
+  }
+  wheel->now = now;
+  while (fired.next != &fired) {
+    timer_node_t *node = fired.next;
+    _unlink(node);
+    node->fn(node);
+    count++;
+  }
+  return count;
+}
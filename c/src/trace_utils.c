@@ -0,0 +1,58 @@
+/**
+ * @file trace_utils.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "trace_utils.h"
+#include <assert.h>
+
+trace_ring_t trace_ring = {.len = TRACE_RING_LEN, .head = 0};
+
+size_t trace_order(const trace_record_t *records, uint32_t len, uint32_t head,
+                   trace_record_t *out) {
+  assert(records);
+  assert(out);
+  assert(len && !(len & (len - 1)));
+  uint32_t num = head < len ? head : len;
+
+  for (uint32_t i = 0; i < num; i++)
+    out[i] = records[(head - num + i) & (len - 1)];
+  return num;
+}
+
+void trace_span_stats(const trace_record_t *rec, size_t num,
+                      trace_span_stat_t *stat) {
+  assert(stat);
+  assert(!num || rec);
+  stat->count = 0;
+  stat->min = UINT32_MAX;
+  stat->max = 0;
+  stat->total = 0;
+
+  for (size_t i = 0; i < num; i++) {
+    if (rec[i].event != stat->exit)
+      continue;
+    // nearest open span of the same instance
+    for (size_t j = i; j-- > 0;) {
+      if (rec[j].inst != rec[i].inst)
+        continue;
+      if (rec[j].event == stat->exit)
+        break;
+      if (rec[j].event == stat->enter) {
+        uint32_t d = rec[i].time - rec[j].time;
+        stat->count++;
+        stat->total += d;
+        stat->min = d < stat->min ? d : stat->min;
+        stat->max = d > stat->max ? d : stat->max;
+        break;
+      }
+    }
+  }
+  if (!stat->count)
+    stat->min = 0;
+}
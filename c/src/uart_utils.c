@@ -11,7 +11,168 @@
 
 #include "uart_utils.h"
 #include "fifo_utils.h"
+#include "trace_utils.h"
 #include <assert.h>
+#include <string.h>
+
+#if UART_UTILS_STATS
+#define STATS_INC(inst, field) ((inst)->stats.field++)
+
+static inline void _stats_full_begin(utils_tick_t *since, bool *full) {
+  if (!*full) {
+    *full = true;
+    *since = utils_clock_now();
+  }
+}
+
+static inline void _stats_full_end(utils_tick_t *since, bool *full,
+                                   uint64_t *ticks) {
+  if (*full) {
+    *full = false;
+    *ticks += (utils_tick_t)(utils_clock_now() - *since);
+  }
+}
+
+static inline int _stats_bucket(utils_tick_t t) {
+  int b = t ? 64 - __builtin_clzll((uint64_t)t) : 0;
+  return b < UART_STATS_LATENCY_BUCKETS ? b : UART_STATS_LATENCY_BUCKETS - 1;
+}
+
+// one byte at a time is sampled from push to consume
+static void _stats_rx_push(uart_t *inst) {
+  uart_stats_t *st = &inst->stats;
+  if (!st->sample_pending) {
+    st->sample_pending = true;
+    st->sample_seq = st->bytes_rx;
+    st->sample_time = utils_clock_now();
+  }
+  st->bytes_rx++;
+  if (fifo_full(inst->rx_fifo))
+    _stats_full_begin(&st->rx_full_since, &st->rx_full);
+}
+
+static void _stats_rx_consume(uart_t *inst) {
+  uart_stats_t *st = &inst->stats;
+  uint32_t consumed = st->bytes_rx - fifo_len(inst->rx_fifo);
+  if (st->sample_pending && (int32_t)(consumed - st->sample_seq) > 0) {
+    st->latency[_stats_bucket(utils_clock_now() - st->sample_time)]++;
+    st->sample_pending = false;
+  }
+  if (!fifo_full(inst->rx_fifo))
+    _stats_full_end(&st->rx_full_since, &st->rx_full, &st->rx_full_ticks);
+}
+#else
+#define STATS_INC(inst, field) ((void)0)
+#endif
+
+#if UART_RX_MARKS
+// called after the byte at index was pushed, so a visible mark always
+// refers to a visible byte
+static void _rx_mark_push(uart_t *inst, size_t index) {
+  uart_rx_mark_t mark = {index, 0};
+
+  if (inst->rx_mark_pending) {
+    inst->rx_mark_pending = false;
+    mark.time = inst->rx_mark_time;
+  } else if (fifo_len(inst->rx_fifo) == 1 ||
+             (inst->rx_mark_interval && !inst->rx_mark_left)) {
+    mark.time = utils_clock_now();
+  } else {
+    if (inst->rx_mark_left)
+      inst->rx_mark_left--;
+    return;
+  }
+  if (inst->rx_mark_interval)
+    inst->rx_mark_left = inst->rx_mark_interval - 1;
+  if (!fifo_full(inst->rx_marks))
+    fifo_push(inst->rx_marks, &mark, 1);
+}
+#endif
+
+#if UART_CAPTURE
+static inline void _capture(uart_t *inst, capture_dir_t dir, const char *c) {
+  if (inst->capture)
+    capture_write(inst->capture, inst->capture_chan, dir, utils_clock_now(),
+                  c, 1);
+}
+#else
+#define _capture(inst, dir, c) ((void)0)
+#endif
+
+#if UART_RX_FILTER
+enum {
+  _filter_hunt = 0, // waiting for the first frame start
+  _filter_header,   // holding bytes until the address
+  _filter_pass,
+  _filter_drop,
+};
+
+static inline bool _filter_accepts(const uart_rx_filter_t *filter,
+                                   unsigned char addr) {
+  return filter->accept[addr >> 5] & (1u << (addr & 31));
+}
+
+/**
+ * @brief run inst->rx_tmp through the filter
+ *
+ * @return int -1 drop the byte, else number of held bytes in rx_hold to
+ * push in front of it
+ */
+static int _rx_filter(uart_t *inst) {
+  const uart_rx_filter_t *filter = inst->rx_filter;
+  char c = inst->rx_tmp;
+
+  if (filter->mode == uart_filter_addr_mark) {
+    if (inst->rx_addr_mark) {
+      inst->rx_addr_mark = false;
+      if (_filter_accepts(filter, c)) {
+        inst->rx_filter_state = _filter_pass;
+      } else {
+        inst->rx_filter_state = _filter_drop;
+        if (filter->mute)
+          filter->mute(inst, inst->privdata);
+      }
+    }
+    return inst->rx_filter_state == _filter_pass ? 0 : -1;
+  }
+
+  if (c == filter->start) {
+    inst->rx_filter_state = _filter_header;
+    inst->rx_filter_pos = 0;
+  }
+  switch (inst->rx_filter_state) {
+  case _filter_header:
+    if (inst->rx_filter_pos < filter->addr_offset) {
+      inst->rx_hold[inst->rx_filter_pos++] = c;
+      return -1;
+    }
+    if (!_filter_accepts(filter, c)) {
+      inst->rx_filter_state = _filter_drop;
+      inst->rx_filter_pos = 0;
+      return -1;
+    }
+    inst->rx_filter_state = _filter_pass;
+    return inst->rx_filter_pos;
+  case _filter_pass:
+    return 0;
+  default:
+    return -1;
+  }
+}
+#endif
+
+static void _fire_event(uart_t *inst, unsigned event) {
+  const uart_event_cfg_t *cfg = inst->event_cfg;
+  if (!cfg || !(cfg->events & event))
+    return;
+  if (!(cfg->deferred & event)) {
+    cfg->fn(inst, event, cfg->userdata);
+  } else if (!__atomic_fetch_or(&inst->event_pending, event,
+                                __ATOMIC_RELAXED) &&
+             cfg->wake) {
+    cfg->wake(inst, cfg->userdata);
+  }
+}
 
 void uart_init(uart_t *inst, const uart_io_t *io, void *data_ptr,
                fifo_t *rx_fifo, fifo_t *tx_fifo) {
@@ -26,7 +187,78 @@ void uart_init(uart_t *inst, const uart_io_t *io, void *data_ptr,
   inst->privdata = data_ptr;
   inst->rx_enable = false;
   inst->tx_enable = false;
+  inst->event_cfg = NULL;
+  inst->event_pending = 0;
+  inst->tx_wait = NULL;
+  inst->tx_wake = NULL;
+  inst->tx_waiting = false;
+#if UART_TX_PRIO_LEVELS
+  memset(inst->tx_queue, 0, sizeof(inst->tx_queue));
+  inst->tx_frame_left = 0;
+  inst->tx_plain_left = 0;
+  inst->tx_frame_level = 0;
+#endif
+#if UART_CAPTURE
+  inst->capture = NULL;
+#endif
+#if UART_RX_MARKS
+  inst->rx_marks = NULL;
+  inst->rx_mark_pending = false;
+#endif
+#if UART_RX_FILTER
+  inst->rx_filter = NULL;
+  inst->rx_filter_state = _filter_hunt;
+  inst->rx_filter_pos = 0;
+  inst->rx_addr_mark = false;
+#endif
+#if UART_UTILS_STATS
+  memset(&inst->stats, 0, sizeof(inst->stats));
+#endif
+}
+
+static inline bool _tx_half_empty(fifo_t *fifo) {
+  return fifo_len(fifo) <= fifo_capacity(fifo) / 2;
+}
+
+#if UART_TX_PRIO_LEVELS
+// frames are stored as u16 little endian length + payload
+static bool _tx_pending(uart_t *inst) {
+  if (inst->tx_frame_left)
+    return true;
+  for (int i = UART_TX_PRIO_LEVELS - 1; i >= 0; i--)
+    if (inst->tx_queue[i] && fifo_len(inst->tx_queue[i]))
+      return true;
+  return fifo_len(inst->tx_fifo) != 0;
+}
+
+static void _tx_pop(uart_t *inst, char *c) {
+  if (!inst->tx_frame_left && !inst->tx_plain_left) {
+    for (int i = UART_TX_PRIO_LEVELS - 1; i >= 0; i--) {
+      fifo_t *queue = inst->tx_queue[i];
+      unsigned char hdr[2];
+      if (!queue || !fifo_len(queue))
+        continue;
+      fifo_pop(queue, hdr, 2);
+      inst->tx_frame_left = hdr[0] | hdr[1] << 8;
+      inst->tx_frame_level = i;
+      break;
+    }
+    // every write commits whole, so tx_fifo ends at a write boundary
+    if (!inst->tx_frame_left)
+      inst->tx_plain_left = fifo_len(inst->tx_fifo);
+  }
+  if (inst->tx_frame_left) {
+    inst->tx_frame_left--;
+    fifo_pop(inst->tx_queue[inst->tx_frame_level], c, 1);
+  } else {
+    inst->tx_plain_left--;
+    fifo_pop(inst->tx_fifo, c, 1);
+  }
 }
+#else
+#define _tx_pending(inst) (fifo_len((inst)->tx_fifo) != 0)
+#define _tx_pop(inst, c) fifo_pop((inst)->tx_fifo, c, 1)
+#endif
 
 size_t uart_write(uart_t *inst, const char *c, size_t num) {
   assert(inst);
@@ -37,13 +269,110 @@ size_t uart_write(uart_t *inst, const char *c, size_t num) {
   if (write_len > num)
     write_len = num;
   fifo_push(fifo, c, write_len);
+#if UART_UTILS_STATS
+  if (fifo_full(fifo))
+    _stats_full_begin(&inst->stats.tx_full_since, &inst->stats.tx_full);
+#endif
 
-  if (!inst->tx_enable) {
+  if (inst->status != uart_status_tx) {
     uart_enable_tx(inst);
   }
   return write_len;
 }
 
+size_t uart_write_reserve(uart_t *inst, char **buf, size_t num) {
+  assert(inst);
+  assert(buf);
+  size_t len = fifo_reserve(inst->tx_fifo, (void **)buf);
+  return len < num ? len : num;
+}
+
+void uart_write_commit(uart_t *inst, size_t num) {
+  assert(inst);
+  if (!num)
+    return;
+  fifo_commit(inst->tx_fifo, num);
+#if UART_UTILS_STATS
+  if (fifo_full(inst->tx_fifo))
+    _stats_full_begin(&inst->stats.tx_full_since, &inst->stats.tx_full);
+#endif
+  if (inst->status != uart_status_tx) {
+    uart_enable_tx(inst);
+  }
+}
+
+size_t uart_write_all(uart_t *inst, const char *c, size_t num,
+                      uint32_t timeout) {
+  assert(inst);
+  assert(c);
+  size_t done = 0;
+  uint32_t waited;
+
+  while (done < num) {
+    done += uart_write(inst, c + done, num - done);
+    if (done == num || !timeout || !inst->tx_wait)
+      break;
+    __atomic_store_n(&inst->tx_waiting, true, __ATOMIC_SEQ_CST);
+    // isr may have drained the fifo before it could see tx_waiting
+    if (!_tx_half_empty(inst->tx_fifo))
+      waited = inst->tx_wait(inst, timeout);
+    else
+      waited = 0;
+    __atomic_store_n(&inst->tx_waiting, false, __ATOMIC_SEQ_CST);
+    if (timeout != UART_WAIT_FOREVER)
+      timeout = waited < timeout ? timeout - waited : 0;
+  }
+  return done;
+}
+
+void uart_set_tx_wait(uart_t *inst, uart_tx_wait_fn_t wait,
+                      void (*wake)(uart_t *inst)) {
+  assert(inst);
+  assert(!wait == !wake);
+  inst->tx_wait = wait;
+  inst->tx_wake = wake;
+}
+
+#if UART_TX_PRIO_LEVELS
+void uart_set_tx_queue(uart_t *inst, unsigned level, fifo_t *fifo) {
+  assert(inst);
+  assert(level < UART_TX_PRIO_LEVELS);
+  assert(!fifo || fifo->type_len == 1);
+  inst->tx_queue[level] = fifo;
+}
+
+size_t uart_write_prio(uart_t *inst, unsigned level, const char *c,
+                       size_t num) {
+  assert(inst);
+  assert(c);
+  assert(num && num <= UINT16_MAX);
+  assert(level < UART_TX_PRIO_LEVELS && inst->tx_queue[level]);
+  fifo_t *fifo = inst->tx_queue[level];
+  size_t mask = fifo->fifo_len - 1;
+  size_t index = fifo->index_end;
+  char *buffer = (char *)fifo->buffer;
+  if (fifo_capacity(fifo) - fifo_len(fifo) < num + 2) {
+#if UART_UTILS_STATS
+    // a frame that fits once the isr drains the queue is a stall
+    if (fifo_capacity(fifo) >= num + 2)
+      _stats_full_begin(&inst->stats.tx_full_since, &inst->stats.tx_full);
+#endif
+    return 0;
+  }
+  // header and payload become visible to the isr with a single commit
+  buffer[index] = num & 0xff;
+  buffer[(index + 1) & mask] = num >> 8;
+  for (size_t i = 0; i < num; i++)
+    buffer[(index + 2 + i) & mask] = c[i];
+  fifo_commit(fifo, num + 2);
+
+  if (inst->status != uart_status_tx) {
+    uart_enable_tx(inst);
+  }
+  return num;
+}
+#endif
+
 size_t uart_read(uart_t *inst, char *c, size_t num) {
   assert(inst);
   assert(c);
@@ -53,22 +382,94 @@ size_t uart_read(uart_t *inst, char *c, size_t num) {
   if (read_len > num)
     read_len = num;
   fifo_pop(fifo, c, read_len);
+#if UART_UTILS_STATS
+  _stats_rx_consume(inst);
+#endif
   return read_len;
 }
 
+#if UART_RX_MARKS
+void uart_set_rx_marks(uart_t *inst, fifo_t *marks, uint16_t interval) {
+  assert(inst);
+  assert(!marks || marks->type_len == sizeof(uart_rx_mark_t));
+  inst->rx_mark_interval = interval;
+  inst->rx_mark_left = 0;
+  inst->rx_mark_pending = false;
+  inst->rx_marks = marks;
+}
+
+void uart_rx_mark(uart_t *inst, utils_tick_t time) {
+  assert(inst);
+  inst->rx_mark_time = time;
+  inst->rx_mark_pending = true;
+}
+#endif
+
+#if UART_CAPTURE
+void uart_set_capture(uart_t *inst, capture_t *cap, uint8_t chan) {
+  assert(inst);
+  inst->capture = cap;
+  inst->capture_chan = chan;
+}
+#endif
+
+#if UART_RX_FILTER
+void uart_filter_init(uart_rx_filter_t *filter, uart_filter_mode_t mode) {
+  assert(filter);
+  memset(filter, 0, sizeof(*filter));
+  filter->mode = mode;
+  filter->addr_offset = 1;
+}
+
+void uart_filter_accept(uart_rx_filter_t *filter, uint8_t addr, bool accept) {
+  assert(filter);
+  if (accept)
+    filter->accept[addr >> 5] |= 1u << (addr & 31);
+  else
+    filter->accept[addr >> 5] &= ~(1u << (addr & 31));
+}
+
+void uart_set_rx_filter(uart_t *inst, const uart_rx_filter_t *filter) {
+  assert(inst);
+  assert(!filter || filter->mode != uart_filter_start ||
+         (filter->addr_offset >= 1 &&
+          filter->addr_offset <= UART_RX_FILTER_HOLD));
+  inst->rx_filter_state = _filter_hunt;
+  inst->rx_filter_pos = 0;
+  inst->rx_addr_mark = false;
+  inst->rx_filter = filter;
+}
+
+size_t uart_rx_held(const uart_t *inst) {
+  assert(inst);
+  return inst->rx_filter_state == _filter_header ? inst->rx_filter_pos : 0;
+}
+
+void uart_rx_addr_mark(uart_t *inst) {
+  assert(inst);
+  inst->rx_addr_mark = true;
+}
+#endif
+
 void uart_enable_tx(uart_t *inst) {
   assert(inst);
   const uart_io_t *io = inst->io;
-  fifo_t *fifo = inst->tx_fifo;
   void *privdata = inst->privdata;
   inst->tx_enable = true;
   switch (inst->status) {
   case uart_status_rx:
-    io->uart_rx_async_abort(privdata);
   case uart_status_idle:
-    if (fifo_len(fifo)) {
-      fifo_pop(fifo, &inst->tx_tmp, 1);
+    if (_tx_pending(inst)) {
+      // keep rx running if there is nothing to send
+      if (inst->status == uart_status_rx) {
+        STATS_INC(inst, rx_abort);
+        io->uart_rx_async_abort(privdata);
+      }
+      STATS_INC(inst, tx_restart);
+      STATS_INC(inst, bytes_tx);
+      _tx_pop(inst, &inst->tx_tmp);
       inst->status = uart_status_tx;
+      _capture(inst, capture_tx, &inst->tx_tmp);
       io->uart_tx_async(&inst->tx_tmp, privdata);
     }
     break;
@@ -126,6 +527,7 @@ void uart_disable_rx(uart_t *inst) {
   case uart_status_idle:
     break;
   case uart_status_rx:
+    STATS_INC(inst, rx_abort);
     io->uart_rx_async_abort(privdata);
     break;
   default:
@@ -133,21 +535,111 @@ void uart_disable_rx(uart_t *inst) {
   }
 }
 
-void uart_isr_handle_rx(uart_t *inst) {
+uart_status_t uart_status(uart_t *inst) {
+  assert(inst);
+  return inst->status;
+}
+
+void uart_set_event_cfg(uart_t *inst, const uart_event_cfg_t *cfg) {
+  assert(inst);
+  assert(!cfg || (cfg->fn && cfg->rx_threshold));
+  inst->event_cfg = cfg;
+  __atomic_store_n(&inst->event_pending, 0, __ATOMIC_RELAXED);
+}
+
+unsigned uart_dispatch_events(uart_t *inst) {
+  const uart_event_cfg_t *cfg;
+  unsigned events;
+  assert(inst);
+  cfg = inst->event_cfg;
+  events = __atomic_exchange_n(&inst->event_pending, 0, __ATOMIC_RELAXED);
+  if (cfg && events)
+    cfg->fn(inst, events, cfg->userdata);
+  return events;
+}
+
+#if UART_UTILS_STATS
+const uart_stats_t *uart_stats(uart_t *inst) {
+  assert(inst);
+  return &inst->stats;
+}
+
+void uart_stats_reset(uart_t *inst) {
+  assert(inst);
+  memset(&inst->stats, 0, sizeof(inst->stats));
+}
+
+void uart_stats_update(uart_t *inst) {
   assert(inst);
+  _stats_rx_consume(inst);
+}
+#endif
+
+// push one received byte, false if rx_fifo is full
+static bool _rx_push(uart_t *inst, char c) {
   fifo_t *fifo = inst->rx_fifo;
+
+  if (fifo_full(fifo))
+    return false;
+#if UART_RX_MARKS
+  size_t index = fifo->index_end;
+  fifo_push(fifo, &c, 1);
+  if (inst->rx_marks)
+    _rx_mark_push(inst, index);
+#else
+  fifo_push(fifo, &c, 1);
+#endif
+#if UART_UTILS_STATS
+  _stats_rx_push(inst);
+#endif
+  if (inst->event_cfg && fifo_len(fifo) == inst->event_cfg->rx_threshold)
+    _fire_event(inst, uart_event_rx_threshold);
+  return true;
+}
+
+void uart_isr_handle_rx(uart_t *inst) {
+  assert(inst);
   const uart_io_t *io = inst->io;
   void *privdata = inst->privdata;
 
-  if (!fifo_full(fifo)) {
-    fifo_push(fifo, &inst->rx_tmp, 1);
-    io->uart_rx_async(&inst->rx_tmp, privdata);
-  } else {
-    // NOTE: completely disable uart rx if fifo is full
-    inst->status = uart_status_idle;
-    inst->rx_enable = false;
-    io->uart_rx_async_abort(privdata);
+  TRACE(trace_uart_isr_rx_enter, inst, (unsigned char)inst->rx_tmp);
+  STATS_INC(inst, isr_rx);
+  // the wire is recorded even if rx_fifo overflows
+  _capture(inst, capture_rx, &inst->rx_tmp);
+#if UART_RX_FILTER
+  if (inst->rx_filter) {
+    int held = _rx_filter(inst);
+    if (held < 0) {
+      // frame of another node, don't touch rx_fifo
+      STATS_INC(inst, rx_filtered);
+      io->uart_rx_async(&inst->rx_tmp, privdata);
+      goto exit;
+    }
+    // never push a partial header
+    if (held && fifo_capacity(inst->rx_fifo) - fifo_len(inst->rx_fifo) <=
+                    (size_t)held)
+      goto overflow;
+    for (int i = 0; i < held; i++) {
+      if (!_rx_push(inst, inst->rx_hold[i]))
+        goto overflow;
+    }
   }
+#endif
+  if (!_rx_push(inst, inst->rx_tmp))
+    goto overflow;
+  io->uart_rx_async(&inst->rx_tmp, privdata);
+  goto exit;
+overflow:
+  // NOTE: completely disable uart rx if fifo is full
+  inst->status = uart_status_idle;
+  inst->rx_enable = false;
+  STATS_INC(inst, rx_overflow);
+  STATS_INC(inst, rx_abort);
+  io->uart_rx_async_abort(privdata);
+  TRACE(trace_uart_rx_overflow, inst, fifo_len(inst->rx_fifo));
+  _fire_event(inst, uart_event_rx_overflow);
+exit:
+  TRACE(trace_uart_isr_rx_exit, inst, 0);
 }
 
 void uart_isr_handle_tx(uart_t *inst) {
@@ -155,7 +647,13 @@ void uart_isr_handle_tx(uart_t *inst) {
   fifo_t *fifo = inst->tx_fifo;
   const uart_io_t *io = inst->io;
   void *privdata = inst->privdata;
-  if (!fifo_len(fifo)) {
+  TRACE(trace_uart_isr_tx_enter, inst, fifo_len(fifo));
+  STATS_INC(inst, isr_tx);
+#if UART_UTILS_STATS
+  _stats_full_end(&inst->stats.tx_full_since, &inst->stats.tx_full,
+                  &inst->stats.tx_full_ticks);
+#endif
+  if (!_tx_pending(inst)) {
     inst->tx_enable = false;
     if (inst->rx_enable && !fifo_full(inst->rx_fifo)) {
       inst->status = uart_status_rx;
@@ -163,8 +661,21 @@ void uart_isr_handle_tx(uart_t *inst) {
     } else {
       inst->status = uart_status_idle;
     }
+    _fire_event(inst, uart_event_tx_drained);
   } else {
-    fifo_pop(fifo, &inst->tx_tmp, 1);
+    size_t len = fifo_len(fifo);
+    STATS_INC(inst, bytes_tx);
+    _tx_pop(inst, &inst->tx_tmp);
+    _capture(inst, capture_tx, &inst->tx_tmp);
+    // a byte from a prio queue leaves tx_fifo as it is
+    if (fifo_len(fifo) != len && fifo_len(fifo) == fifo_capacity(fifo) / 2)
+      _fire_event(inst, uart_event_tx_space);
     inst->io->uart_tx_async(&inst->tx_tmp, privdata);
   }
+  if (__atomic_load_n(&inst->tx_waiting, __ATOMIC_SEQ_CST) &&
+      _tx_half_empty(fifo)) {
+    inst->tx_waiting = false;
+    inst->tx_wake(inst);
+  }
+  TRACE(trace_uart_isr_tx_exit, inst, 0);
 }
@@ -9,19 +9,91 @@
  *
  */
 
-#include "uart_utils.h"
+#include "stm32_uart_ll.h"
 #include "usart.h"
 #include <assert.h>
-#include <stdlib.h>
-
-static uart_t *stm32_instance[4] = {NULL};
-static const int stm32_instance_num =
-    sizeof(stm32_instance) / sizeof(stm32_instance[0]);
+#include <stdint.h>
+
+typedef struct {
+  uart_t inst; // keep first, slot is found from inst by cast
+  fifo_t rx, tx;
+#if STM32_UART_RX_FIFO_SIZE
+  char rx_buf[STM32_UART_RX_FIFO_SIZE];
+#endif
+#if STM32_UART_TX_FIFO_SIZE
+  char tx_buf[STM32_UART_TX_FIFO_SIZE];
+#endif
+  USART_TypeDef *periph;
+  bool used;
+} stm32_uart_slot_t;
+
+_Static_assert(!(STM32_UART_RX_FIFO_SIZE & (STM32_UART_RX_FIFO_SIZE - 1)),
+               "STM32_UART_RX_FIFO_SIZE must be 2^x");
+_Static_assert(!(STM32_UART_TX_FIFO_SIZE & (STM32_UART_TX_FIFO_SIZE - 1)),
+               "STM32_UART_TX_FIFO_SIZE must be 2^x");
+
+static stm32_uart_slot_t stm32_pool[STM32_UART_POOL_SIZE];
+
+// peripheral -> instance, indexed by stm32_uart_index
+static uart_t *stm32_instance[STM32_UART_MAP_SIZE];
 
 static inline UART_HandleTypeDef *to_huart(void *data) {
   return (UART_HandleTypeDef *)data;
 }
 
+// constant time, the switch compiles to a jump table or a short search
+static int stm32_uart_index(USART_TypeDef *periph) {
+  switch ((uintptr_t)periph) {
+#ifdef USART1
+  case USART1_BASE:
+    return 0;
+#endif
+#ifdef USART2
+  case USART2_BASE:
+    return 1;
+#endif
+#ifdef USART3
+  case USART3_BASE:
+    return 2;
+#endif
+#ifdef UART4
+  case UART4_BASE:
+    return 3;
+#endif
+#ifdef UART5
+  case UART5_BASE:
+    return 4;
+#endif
+#ifdef USART6
+  case USART6_BASE:
+    return 5;
+#endif
+#ifdef UART7
+  case UART7_BASE:
+    return 6;
+#endif
+#ifdef UART8
+  case UART8_BASE:
+    return 7;
+#endif
+#ifdef UART9
+  case UART9_BASE:
+    return 8;
+#endif
+#ifdef UART10
+  case UART10_BASE:
+    return 9;
+#endif
+  default:
+    return -1;
+  }
+}
+
+static inline uart_t *stm32_uart_lookup(UART_HandleTypeDef *huart) {
+  int index = stm32_uart_index(huart->Instance);
+  return index < 0 ? NULL : stm32_instance[index];
+}
+
 __attribute__((weak)) void stm32_uart_rx_async(char *ch, void *data) {
   HAL_UART_Receive_IT(to_huart(data), (uint8_t *)ch, 1);
 }
@@ -40,138 +112,98 @@ __attribute__((weak)) void stm32_uart_rx_async_abort(void *data) {
   // HAL_UART_AbortReceive_IT(to_huart(data));
 }
 
+static const uart_io_t stm32_uart_io = {
+    .uart_rx_async = stm32_uart_rx_async,
+    .uart_rx_async_abort = stm32_uart_rx_async_abort,
+    .uart_tx_async = stm32_uart_tx_async,
+    .uart_tx_async_abort = stm32_uart_tx_async_abort,
+};
+
 static void stm32_isr_tx_handler(UART_HandleTypeDef *huart) {
-  uart_t *inst;
-  for (int i = 0; i < stm32_instance_num; i++) {
-    inst = stm32_instance[i];
-    if (to_huart(inst->privdata)->Instance == huart->Instance) {
-      uart_isr_handle_tx(inst);
-      return;
-    }
-  }
+  uart_t *inst = stm32_uart_lookup(huart);
+  if (inst)
+    uart_isr_handle_tx(inst);
 }
 
 static void stm32_isr_rx_handler(UART_HandleTypeDef *huart) {
-  uart_t *inst;
-  for (int i = 0; i < stm32_instance_num; i++) {
-    inst = stm32_instance[i];
-    if (to_huart(inst->privdata)->Instance == huart->Instance) {
-      uart_isr_handle_rx(inst);
-      return;
-    }
-  }
+  uart_t *inst = stm32_uart_lookup(huart);
+  if (inst)
+    uart_isr_handle_rx(inst);
+}
+
+static inline void stm32_fifo_init(fifo_t *fifo, void *buffer, size_t len) {
+  fifo->fifo_len = len;
+  fifo->type_len = 1;
+  fifo->index_start = 0;
+  fifo->index_end = 0;
+  fifo->buffer = buffer;
 }
 
 uart_t *stm32_uart_init(UART_HandleTypeDef *huart, fifo_t *rx, fifo_t *tx) {
-  uart_t *inst;
-  uart_io_t *io;
-  const int fifo_size = 32;
-  int index = -1;
-
-  for (int i = 0; i < stm32_instance_num; i++) {
-    if (!stm32_instance[i]) {
-      index = i;
+  stm32_uart_slot_t *slot = NULL;
+  int index;
+
+  if (!huart)
+    return NULL;
+  index = stm32_uart_index(huart->Instance);
+  if (index < 0)
+    return NULL;
+  if (stm32_instance[index])
+    return stm32_instance[index];
+
+  for (int i = 0; i < STM32_UART_POOL_SIZE; i++) {
+    if (!stm32_pool[i].used) {
+      slot = &stm32_pool[i];
       break;
-    } else if (to_huart(stm32_instance[i]->privdata) &&
-               to_huart(stm32_instance[i]->privdata)->Instance ==
-                   huart->Instance) {
-      return stm32_instance[i];
     }
   }
-
-  if (!huart && index < 0)
-    goto fatal1;
-
-  inst = malloc(sizeof(*inst));
-  if (!inst)
-    goto fatal2;
-
-  io = malloc(sizeof(*inst->io));
-  if (!io)
-    goto fatal3;
-  io->uart_rx_async = stm32_uart_rx_async;
-  io->uart_rx_async_abort = stm32_uart_rx_async_abort;
-  io->uart_tx_async = stm32_uart_tx_async;
-  io->uart_tx_async_abort = stm32_uart_tx_async_abort;
-  inst->io = io;
-
-  if (!rx && !tx) {
-    inst->rx_fifo = malloc(sizeof(*inst->rx_fifo));
-    if (!inst->rx_fifo)
-      goto fatal4;
-
-    inst->tx_fifo = malloc(sizeof(*inst->tx_fifo));
-    if (!inst->tx_fifo)
-      goto fatal5;
-
-    inst->privdata = huart;
-    inst->status = uart_status_idle;
-    inst->tx_enable = 0;
-    inst->rx_enable = 0;
-
-    inst->rx_fifo->buffer = malloc(fifo_size * 2);
-    if (!inst->rx_fifo->buffer)
-      goto fatal6;
-    inst->rx_fifo->fifo_len = fifo_size;
-    inst->rx_fifo->type_len = 1;
-    inst->rx_fifo->index_start = 0;
-    inst->rx_fifo->index_end = 0;
-
-    inst->tx_fifo->fifo_len = fifo_size;
-    inst->tx_fifo->type_len = 1;
-    inst->tx_fifo->index_start = 0;
-    inst->tx_fifo->index_end = 0;
-    inst->tx_fifo->buffer = ((char *)inst->rx_fifo->buffer) + fifo_size;
-  } else {
-    inst->rx_fifo = rx;
-    inst->tx_fifo = tx;
-    assert(inst->tx_fifo->type_len == 1);
-    assert(inst->tx_fifo->buffer);
-    assert(inst->rx_fifo->type_len == 1);
-    assert(inst->rx_fifo->buffer);
+  if (!slot)
+    return NULL;
+
+  if (!rx) {
+#if STM32_UART_RX_FIFO_SIZE
+    stm32_fifo_init(&slot->rx, slot->rx_buf, sizeof(slot->rx_buf));
+    rx = &slot->rx;
+#else
+    return NULL;
+#endif
   }
+  if (!tx) {
+#if STM32_UART_TX_FIFO_SIZE
+    stm32_fifo_init(&slot->tx, slot->tx_buf, sizeof(slot->tx_buf));
+    tx = &slot->tx;
+#else
+    return NULL;
+#endif
+  }
+  assert(rx->type_len == 1 && rx->buffer);
+  assert(tx->type_len == 1 && tx->buffer);
+
+  uart_init(&slot->inst, &stm32_uart_io, huart, rx, tx);
+  slot->periph = huart->Instance;
+  slot->used = true;
 
   HAL_UART_RegisterCallback(huart, HAL_UART_TX_COMPLETE_CB_ID,
                             stm32_isr_tx_handler);
   HAL_UART_RegisterCallback(huart, HAL_UART_RX_COMPLETE_CB_ID,
                             stm32_isr_rx_handler);
 
-  stm32_instance[index] = inst;
-
-  return inst;
-fatal6:
-  free(inst->rx_fifo->buffer);
-fatal5:
-  free(inst->tx_fifo);
-fatal4:
-  free(inst->rx_fifo);
-fatal3:
-  free(io);
-fatal2:
-  free(inst);
-fatal1:
-  return NULL;
+  stm32_instance[index] = &slot->inst;
+
+  return &slot->inst;
 }
 
 void stm32_uart_deinit(uart_t *inst) {
-  int index = -1;
+  stm32_uart_slot_t *slot = (stm32_uart_slot_t *)inst;
+  int index;
 
-  for (int i = 0; i < stm32_instance_num; i++) {
-    if (stm32_instance[i] == inst) {
-      index = i;
-      break;
-    }
-  }
-
-  if (index < 0)
+  if (!inst || slot < stm32_pool || slot >= stm32_pool + STM32_UART_POOL_SIZE ||
+      !slot->used)
     return;
 
   uart_disable_rx(inst);
   uart_disable_tx(inst);
+  index = stm32_uart_index(slot->periph);
   stm32_instance[index] = NULL;
-  free(inst->rx_fifo->buffer);
-  free(inst->tx_fifo);
-  free(inst->rx_fifo);
-  free((void *)inst->io);
-  free(inst);
-}
\ No newline at end of file
+  slot->used = false;
+}
@@ -14,13 +14,40 @@
 
 #include <stm32f4xx_hal.h>
 
+// instances live in a static pool, no heap is used
+#ifndef STM32_UART_POOL_SIZE
+#define STM32_UART_POOL_SIZE 4
+#endif
+
+// size of pool owned fifos, 2^x, 0 to always pass fifos to stm32_uart_init
+#ifndef STM32_UART_RX_FIFO_SIZE
+#define STM32_UART_RX_FIFO_SIZE 32
+#endif
+
+#ifndef STM32_UART_TX_FIFO_SIZE
+#define STM32_UART_TX_FIFO_SIZE 32
+#endif
+
+/*
+ * per port fifo size, define the fifos at file scope:
+ *
+ *   FIFO_DEFINE(usart1_rx, 256, char);
+ *   FIFO_DEFINE(usart1_tx, 64, char);
+ *   stm32_uart_init(&huart1, FIFO_PTR(usart1_rx), FIFO_PTR(usart1_tx));
+ */
+
+// USART1..UART10, see stm32_uart_index
+#define STM32_UART_MAP_SIZE 10
+
 /**
  * @brief init uart instance from huart
  *
  * @param huart
- * @param rx fifo pointer, leave NULL will allocate it automatically(default fifo size)
- * @param tx fifo pointer, leave NULL will allocate it automatically(default fifo size)
- * @return uart_t*
+ * @param rx fifo pointer, leave NULL to use the pool fifo
+ * (STM32_UART_RX_FIFO_SIZE), pass a FIFO_DEFINE one for a per port size
+ * @param tx fifo pointer, leave NULL to use the pool fifo
+ * (STM32_UART_TX_FIFO_SIZE), pass a FIFO_DEFINE one for a per port size
+ * @return uart_t* NULL if pool is exhausted or huart is unknown
  */
 uart_t *stm32_uart_init(UART_HandleTypeDef *huart, fifo_t *rx, fifo_t *tx);
 
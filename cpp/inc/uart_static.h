@@ -0,0 +1,215 @@
+/**
+ * @file uart_static.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief uart state machine of uart_utils.c with a compile time io policy
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * Uart<IoPolicy, RxFifo, TxFifo> runs the same idle/rx/tx state machine as
+ * uart_t, but the io backend is a template parameter instead of uart_io_t,
+ * so the whole isr path can be inlined. Events, stats, priority queues and
+ * rx marks of uart_t are not part of it.
+ *
+ * IoPolicy provides:
+ *   void rx_async(char *ch);
+ *   void rx_async_abort();
+ *   void tx_async(const char *ch);
+ *   void tx_async_abort();
+ *
+ * @code
+ *
+ * struct usart1_io {
+ *   void rx_async(char *ch) { LL_USART_EnableIT_RXNE(USART1); slot = ch; }
+ *   ...
+ * };
+ * static utils::Uart<usart1_io, utils::StaticFifo<256>,
+ *                    utils::StaticFifo<256>> uart1;
+ *
+ * extern "C" void USART1_IRQHandler(void) { ... uart1.isr_rx(); }
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "uart_utils.h"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+namespace utils {
+
+/**
+ * @brief single producer single consumer byte ring, N must be 2^x
+ */
+template <size_t N> class StaticFifo {
+  static_assert(N >= 2 && !(N & (N - 1)), "N must be 2^x");
+
+public:
+  size_t capacity() const { return N - 1; }
+  size_t len() const { return (load(end_) - load(start_)) & (N - 1); }
+  bool full() const { return len() == N - 1; }
+
+  void push(const char *data, size_t num) {
+    assert(len() + num <= capacity());
+    size_t end = end_;
+    size_t first = num < N - end ? num : N - end;
+    memcpy(buf_ + end, data, first);
+    memcpy(buf_, data + first, num - first);
+    store(end_, (end + num) & (N - 1));
+  }
+
+  void pop(char *data, size_t num) {
+    assert(len() >= num);
+    size_t start = start_;
+    size_t first = num < N - start ? num : N - start;
+    memcpy(data, buf_ + start, first);
+    memcpy(data + first, buf_, num - first);
+    store(start_, (start + num) & (N - 1));
+  }
+
+  void push(char c) {
+    buf_[end_] = c;
+    store(end_, (end_ + 1) & (N - 1));
+  }
+
+  char pop() {
+    char c = buf_[start_];
+    store(start_, (start_ + 1) & (N - 1));
+    return c;
+  }
+
+private:
+  static size_t load(const size_t &index) {
+    return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+  }
+  static void store(size_t &index, size_t value) {
+    __atomic_store_n(&index, value, __ATOMIC_RELEASE);
+  }
+
+  size_t start_ = 0, end_ = 0;
+  char buf_[N];
+};
+
+template <typename IoPolicy, typename RxFifo, typename TxFifo>
+class Uart : private IoPolicy {
+public:
+  Uart() = default;
+  explicit Uart(const IoPolicy &io) : IoPolicy(io) {}
+
+  IoPolicy &io() { return *this; }
+  RxFifo &rx_fifo() { return rx_fifo_; }
+  TxFifo &tx_fifo() { return tx_fifo_; }
+  uart_status_t status() const { return status_; }
+
+  /**
+   * @brief write data into tx buffer, start transmit
+   * @return size_t actually data writen in buffer
+   */
+  size_t write(const char *c, size_t num) {
+    size_t space = tx_fifo_.capacity() - tx_fifo_.len();
+    if (num > space)
+      num = space;
+    tx_fifo_.push(c, num);
+    if (status_ != uart_status_tx)
+      enable_tx();
+    return num;
+  }
+
+  /**
+   * @brief read data from rx buffer
+   * @return size_t actually data readded from buffer
+   */
+  size_t read(char *c, size_t num) {
+    size_t len = rx_fifo_.len();
+    if (num > len)
+      num = len;
+    rx_fifo_.pop(c, num);
+    return num;
+  }
+
+  void enable_tx() {
+    tx_enable_ = true;
+    if (status_ == uart_status_tx || !tx_fifo_.len())
+      return;
+    // keep rx running if there is nothing to send
+    if (status_ == uart_status_rx)
+      IoPolicy::rx_async_abort();
+    tx_tmp_ = tx_fifo_.pop();
+    status_ = uart_status_tx;
+    IoPolicy::tx_async(&tx_tmp_);
+  }
+
+  void disable_tx() {
+    tx_enable_ = false;
+    if (status_ == uart_status_tx) {
+      IoPolicy::tx_async_abort();
+      status_ = uart_status_idle;
+    }
+  }
+
+  void enable_rx() {
+    rx_enable_ = true;
+    switch (status_) {
+    case uart_status_tx:
+      IoPolicy::tx_async_abort();
+      // fall through
+    case uart_status_idle:
+      status_ = uart_status_rx;
+      IoPolicy::rx_async(&rx_tmp_);
+      break;
+    default:
+      break;
+    }
+  }
+
+  void disable_rx() {
+    rx_enable_ = false;
+    if (status_ == uart_status_rx)
+      IoPolicy::rx_async_abort();
+  }
+
+  /**
+   * @brief rx isr handler
+   */
+  void isr_rx() {
+    if (!rx_fifo_.full()) {
+      rx_fifo_.push(rx_tmp_);
+      IoPolicy::rx_async(&rx_tmp_);
+    } else {
+      // NOTE: completely disable uart rx if fifo is full
+      status_ = uart_status_idle;
+      rx_enable_ = false;
+      IoPolicy::rx_async_abort();
+    }
+  }
+
+  /**
+   * @brief tx isr handler
+   */
+  void isr_tx() {
+    if (!tx_fifo_.len()) {
+      tx_enable_ = false;
+      if (rx_enable_ && !rx_fifo_.full()) {
+        status_ = uart_status_rx;
+        IoPolicy::rx_async(&rx_tmp_);
+      } else {
+        status_ = uart_status_idle;
+      }
+    } else {
+      tx_tmp_ = tx_fifo_.pop();
+      IoPolicy::tx_async(&tx_tmp_);
+    }
+  }
+
+private:
+  RxFifo rx_fifo_;
+  TxFifo tx_fifo_;
+  char rx_tmp_ = 0, tx_tmp_ = 0;
+  uart_status_t status_ = uart_status_idle;
+  bool tx_enable_ = false;
+  bool rx_enable_ = false;
+};
+
+} // namespace utils
@@ -0,0 +1,296 @@
+/**
+ * @file uart_coro.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief C++20 coroutine layer on top of uart_loop
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * A coro_port is a uart_loop port whose deferred uart events resume the
+ * coroutine waiting on it, so a protocol session is a plain sequential
+ * function and thousands of them share one thread. Events are latched by
+ * the loop backend and dispatched after each loop iteration, never from
+ * inside the rx/tx path. One reader and one writer may wait on a port at a
+ * time.
+ *
+ * Requires -std=c++20 (USE_CORO), the header is empty otherwise.
+ *
+ * @code
+ *
+ * utils::coro_task session(utils::coro_port &port) {
+ *   char frame[64];
+ *   for (;;) {
+ *     int n = co_await port.read_frame(match_fn, frame, sizeof(frame));
+ *     co_await port.write(frame, n);
+ *   }
+ * }
+ *
+ * utils::coro_loop loop;
+ * utils::coro_port port(loop, fd, FIFO_PTR(rx), FIFO_PTR(tx));
+ * session(port);
+ * for (;;)
+ *   loop.run_once(-1);
+ *
+ * @endcode
+ */
+#pragma once
+
+#if __cpp_impl_coroutine
+
+#include "uart_loop.h"
+#include <algorithm>
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief fire and forget coroutine, starts eagerly and frees itself at the
+ * end
+ */
+struct coro_task {
+  struct promise_type {
+    coro_task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+class coro_port;
+
+class coro_loop {
+public:
+  coro_loop() : ok_(uart_loop_init(&loop_) == 0) {}
+  ~coro_loop() {
+    if (ok_)
+      uart_loop_deinit(&loop_);
+  }
+  coro_loop(const coro_loop &) = delete;
+  coro_loop &operator=(const coro_loop &) = delete;
+
+  bool ok() const { return ok_; }
+  uart_loop_t *loop() { return &loop_; }
+
+  /**
+   * @brief run the uart loop once, then resume ready coroutines
+   *
+   * @param timeout_ms -1 for infinite
+   * @return int handled events and ports, -errno on failure
+   */
+  inline int run_once(int timeout_ms);
+
+private:
+  friend class coro_port;
+
+  uart_loop_t loop_;
+  bool ok_;
+  std::vector<coro_port *> ready_;
+};
+
+class coro_port {
+  struct op {
+    coro_port *port;
+    bool tx;
+    std::coroutine_handle<> handle;
+    virtual bool try_complete() = 0;
+  };
+
+  template <typename Op> struct awaiter : Op {
+    template <typename... Args>
+    explicit awaiter(coro_port *port, Args... args) : Op(args...) {
+      this->port = port;
+    }
+    bool await_ready() { return this->try_complete(); }
+    void await_suspend(std::coroutine_handle<> h) {
+      this->handle = h;
+      this->port->wait(this);
+    }
+    auto await_resume() { return this->result(); }
+  };
+
+  struct readable_op : op {
+    readable_op() { this->tx = false; }
+    bool try_complete() override {
+      return fifo_len(this->port->uart()->rx_fifo) != 0;
+    }
+    void result() {}
+  };
+
+  struct frame_op : op {
+    protocal_match_fn_t fn;
+    char *buf;
+    size_t size;
+    int re = 0;
+    frame_op(protocal_match_fn_t fn, char *buf, size_t size)
+        : fn(fn), buf(buf), size(size) {
+      this->tx = false;
+    }
+    bool try_complete() override {
+      fifo_t *fifo = this->port->uart()->rx_fifo;
+      bool consumed = false;
+      while (fifo_len(fifo)) {
+        size_t len = fifo_len(fifo);
+        re = protocal_find_frame(fifo, fn, buf, size);
+        consumed |= fifo_len(fifo) != len;
+        if (re > 0 || fifo_len(fifo) == len)
+          break;
+      }
+      // the loop stops reading while rx_fifo is full
+      if (consumed)
+        uart_loop_update(&this->port->port_);
+      return re > 0;
+    }
+    int result() { return re; }
+  };
+
+  struct write_op : op {
+    const char *buf;
+    size_t len;
+    size_t done = 0;
+    write_op(const char *buf, size_t len) : buf(buf), len(len) {
+      this->tx = true;
+    }
+    bool try_complete() override {
+      if (done < len)
+        done += uart_write(this->port->uart(), buf + done, len - done);
+      return done == len;
+    }
+    size_t result() { return done; }
+  };
+
+public:
+  coro_port(coro_loop &loop, int fd, fifo_t *rx_fifo, fifo_t *tx_fifo)
+      : loop_(loop) {
+    cfg_.fn = on_event;
+    cfg_.wake = on_wake;
+    cfg_.userdata = this;
+    cfg_.events = uart_event_rx_threshold | uart_event_rx_overflow |
+                  uart_event_tx_space | uart_event_tx_drained;
+    cfg_.deferred = cfg_.events;
+    cfg_.rx_threshold = 1;
+    err_ = uart_loop_add(loop.loop(), &port_, fd, rx_fifo, tx_fifo);
+    if (err_)
+      return;
+    uart_set_event_cfg(&port_.uart, &cfg_);
+    uart_enable_rx(&port_.uart);
+  }
+
+  ~coro_port() {
+    auto &ready = loop_.ready_;
+    ready.erase(std::remove(ready.begin(), ready.end(), this), ready.end());
+    if (!err_)
+      uart_loop_remove(&port_);
+  }
+
+  coro_port(const coro_port &) = delete;
+  coro_port &operator=(const coro_port &) = delete;
+
+  /**
+   * @return int 0 if the port was added to the loop, -errno otherwise
+   */
+  int error() const { return err_; }
+  uart_t *uart() { return &port_.uart; }
+
+  /**
+   * @brief resume once rx_fifo holds data, read it with uart_read
+   */
+  awaiter<readable_op> readable() { return awaiter<readable_op>(this); }
+
+  /**
+   * @brief resume with the size of the next frame found by fn
+   */
+  awaiter<frame_op> read_frame(protocal_match_fn_t fn, char *buf,
+                               size_t size) {
+    return awaiter<frame_op>(this, fn, buf, size);
+  }
+
+  /**
+   * @brief resume once all of buf is queued in tx_fifo
+   *
+   * A buf larger than tx_fifo is queued in chunks, refilled each time
+   * tx_fifo drops to half its capacity.
+   */
+  awaiter<write_op> write(const char *buf, size_t len) {
+    return awaiter<write_op>(this, buf, len);
+  }
+
+private:
+  friend class coro_loop;
+
+  void arm_rx() {
+    // fire again on the next byte
+    cfg_.rx_threshold = fifo_len(port_.uart.rx_fifo) + 1;
+  }
+
+  void wait(op *o) {
+    op *&slot = o->tx ? tx_wait_ : rx_wait_;
+    assert(!slot);
+    slot = o;
+    if (!o->tx)
+      arm_rx();
+  }
+
+  void complete(op *&slot) {
+    op *o = slot;
+    if (!o->try_complete()) {
+      if (!o->tx)
+        arm_rx();
+      return;
+    }
+    slot = nullptr;
+    o->handle.resume();
+  }
+
+  static void on_event(uart_t *, unsigned events, void *userdata) {
+    auto self = static_cast<coro_port *>(userdata);
+    if (self->rx_wait_ &&
+        (events & (uart_event_rx_threshold | uart_event_rx_overflow)))
+      self->complete(self->rx_wait_);
+    // refill at half, the rest of tx_fifo keeps the line busy meanwhile
+    if (self->tx_wait_ &&
+        (events & (uart_event_tx_space | uart_event_tx_drained)))
+      self->complete(self->tx_wait_);
+  }
+
+  static void on_wake(uart_t *, void *userdata) {
+    auto self = static_cast<coro_port *>(userdata);
+    if (self->queued_)
+      return;
+    self->queued_ = true;
+    self->loop_.ready_.push_back(self);
+  }
+
+  coro_loop &loop_;
+  uart_loop_port_t port_;
+  uart_event_cfg_t cfg_;
+  op *rx_wait_ = nullptr;
+  op *tx_wait_ = nullptr;
+  bool queued_ = false; // in loop_.ready_
+  int err_;
+};
+
+int coro_loop::run_once(int timeout_ms) {
+  int re = uart_loop_run_once(&loop_, timeout_ms);
+  if (re < 0)
+    return re;
+  std::vector<coro_port *> ready;
+  while (!ready_.empty()) {
+    ready.swap(ready_);
+    for (auto port : ready) {
+      port->queued_ = false;
+      uart_dispatch_events(port->uart());
+      re++;
+    }
+    ready.clear();
+  }
+  return re;
+}
+
+} // namespace utils
+
+#endif
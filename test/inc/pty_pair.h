@@ -0,0 +1,45 @@
+/**
+ * @file pty_pair.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief raw pty pair standing in for a serial line in tests and benchmarks
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+struct pty_pair {
+  int master; // far end of the line
+  int slave;  // device side, handed to uart_loop
+
+  pty_pair() : master(-1), slave(-1) {
+    struct termios tio;
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master))
+      return;
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &tio))
+      return;
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+  }
+
+  pty_pair(const pty_pair &) = delete;
+  pty_pair &operator=(const pty_pair &) = delete;
+
+  ~pty_pair() {
+    if (slave >= 0)
+      close(slave);
+    if (master >= 0)
+      close(master);
+  }
+
+  bool ok() const { return master >= 0 && slave >= 0; }
+};
@@ -0,0 +1,261 @@
+/**
+ * @file uart_sim.h
+ * @author savent (savent_gate@outlook.com)
+ * @brief timing accurate uart device model driven by a virtual clock
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * The model implements uart_io_t for one uart_t. Bytes fed from the far end
+ * occupy the wire for bits_per_byte / baud, land in a hardware rx fifo of
+ * hw_fifo_depth bytes (overrun when full) and raise the rx interrupt after
+ * irq_latency_ns. Transmitted bytes complete after one byte time and raise
+ * the tx interrupt the same way. Time only advances in run_until(), isr
+ * handlers run in zero virtual time, so results are deterministic.
+ *
+ * @code
+ *
+ * uart_sim sim(uart_sim::config{});
+ * sim.attach(&uart, &rx_fifo, &tx_fifo);
+ * uart_enable_rx(&uart);
+ * sim.feed("Hello", 5);
+ * sim.run();
+ * // sim.now(), sim.rx_latency(), sim.stat() ...
+ *
+ * @endcode
+ */
+#pragma once
+
+#include "uart_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+class uart_sim {
+public:
+  struct config {
+    uint32_t baud = 115200;
+    uint32_t bits_per_byte = 10; // start + 8 data + stop
+    uint64_t irq_latency_ns = 1000;
+    size_t hw_fifo_depth = 1; // 1 models a plain data register
+    double framing_error_rate = 0; // byte arrives corrupted
+    double drop_rate = 0;          // byte never arrives
+    uint32_t seed = 1;
+    bool measure_cpu = false; // time isr handlers with the host clock
+  };
+
+  struct stat_t {
+    uint64_t rx_wire = 0;    // bytes fed on the wire
+    uint64_t rx_isr = 0;     // bytes handed to uart_isr_handle_rx
+    uint64_t rx_overrun = 0; // lost because the hw fifo was full
+    uint64_t rx_framing = 0; // delivered corrupted
+    uint64_t rx_dropped = 0; // lost on the wire
+    uint64_t tx_wire = 0;    // bytes completed on the wire
+    uint64_t isr_calls = 0;
+    uint64_t isr_cpu_ns = 0; // host time spent in isr handlers
+  };
+
+  explicit uart_sim(const config &cfg)
+      : cfg_(cfg), rng_(cfg.seed),
+        byte_ns_(uint64_t(cfg.bits_per_byte) * 1000000000ull / cfg.baud) {
+    io_.uart_rx_async = rx_async;
+    io_.uart_rx_async_abort = rx_async_abort;
+    io_.uart_tx_async = tx_async;
+    io_.uart_tx_async_abort = tx_async_abort;
+  }
+
+  uart_sim(const uart_sim &) = delete;
+  uart_sim &operator=(const uart_sim &) = delete;
+
+  void attach(uart_t *inst, fifo_t *rx_fifo, fifo_t *tx_fifo) {
+    inst_ = inst;
+    uart_init(inst, &io_, this, rx_fifo, tx_fifo);
+  }
+
+  uint64_t now() const { return now_; }
+  uint64_t byte_ns() const { return byte_ns_; }
+  const stat_t &stat() const { return stat_; }
+
+  /**
+   * @brief far end sends bytes back to back, starting no earlier than at
+   */
+  void feed(const void *data, size_t len, uint64_t at = 0) {
+    const char *p = static_cast<const char *>(data);
+    uint64_t t = std::max({at, now_, rx_line_free_});
+    for (size_t i = 0; i < len; i++) {
+      t += byte_ns_;
+      push({t, seq_++, ev_rx_byte, p[i], 0});
+    }
+    rx_line_free_ = t;
+  }
+
+  /**
+   * @brief process events up to time t
+   */
+  void run_until(uint64_t t) {
+    while (!events_.empty() && events_.top().time <= t) {
+      event ev = events_.top();
+      events_.pop();
+      now_ = ev.time;
+      handle(ev);
+    }
+    now_ = std::max(now_, t);
+  }
+
+  /**
+   * @brief process events until the model is quiet
+   */
+  void run() {
+    while (!events_.empty())
+      run_until(events_.top().time);
+  }
+
+  /**
+   * @brief bytes seen by the far end, with wire completion time
+   */
+  const std::vector<std::pair<uint64_t, char>> &tx_log() const {
+    return tx_log_;
+  }
+
+  /**
+   * @brief per rx byte: time from end of byte on the wire to its isr
+   */
+  const std::vector<uint64_t> &rx_latency() const { return rx_latency_; }
+
+  uint64_t max_rx_latency() const {
+    return rx_latency_.empty()
+               ? 0
+               : *std::max_element(rx_latency_.begin(), rx_latency_.end());
+  }
+
+private:
+  enum event_type { ev_rx_byte, ev_rx_irq, ev_tx_irq };
+
+  struct event {
+    uint64_t time;
+    uint64_t seq; // keeps FIFO order of simultaneous events
+    event_type type;
+    char data;
+    uint64_t gen;
+    bool operator>(const event &o) const {
+      return time != o.time ? time > o.time : seq > o.seq;
+    }
+  };
+
+  static uart_sim *self(void *p) { return static_cast<uart_sim *>(p); }
+
+  static void rx_async(char *ch, void *data) {
+    auto s = self(data);
+    s->rx_ptr_ = ch;
+    s->schedule_rx_irq();
+  }
+
+  static void rx_async_abort(void *data) { self(data)->rx_ptr_ = nullptr; }
+
+  static void tx_async(const char *ch, void *data) {
+    auto s = self(data);
+    uint64_t done = std::max(s->now_, s->tx_line_free_) + s->byte_ns_;
+    s->tx_line_free_ = done;
+    s->stat_.tx_wire++;
+    s->tx_log_.emplace_back(done, *ch);
+    s->push({done + s->cfg_.irq_latency_ns, s->seq_++, ev_tx_irq, 0,
+             s->tx_gen_});
+  }
+
+  static void tx_async_abort(void *data) { self(data)->tx_gen_++; }
+
+  void push(const event &ev) { events_.push(ev); }
+
+  void schedule_rx_irq() {
+    if (rx_irq_pending_ || !rx_ptr_ || hw_fifo_.empty())
+      return;
+    rx_irq_pending_ = true;
+    push({now_ + cfg_.irq_latency_ns, seq_++, ev_rx_irq, 0, 0});
+  }
+
+  bool chance(double rate) {
+    std::uniform_real_distribution<double> dist(0, 1);
+    return rate > 0 && dist(rng_) < rate;
+  }
+
+  template <typename Fn> void isr(Fn fn) {
+    stat_.isr_calls++;
+    if (!cfg_.measure_cpu) {
+      fn();
+      return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    stat_.isr_cpu_ns +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+  }
+
+  void handle(const event &ev) {
+    switch (ev.type) {
+    case ev_rx_byte: {
+      char c = ev.data;
+      stat_.rx_wire++;
+      if (chance(cfg_.drop_rate)) {
+        stat_.rx_dropped++;
+        break;
+      }
+      if (chance(cfg_.framing_error_rate)) {
+        stat_.rx_framing++;
+        c ^= 0x80;
+      }
+      if (hw_fifo_.size() >= cfg_.hw_fifo_depth) {
+        stat_.rx_overrun++;
+        break;
+      }
+      hw_fifo_.emplace_back(now_, c);
+      schedule_rx_irq();
+      break;
+    }
+    case ev_rx_irq: {
+      rx_irq_pending_ = false;
+      if (!rx_ptr_ || hw_fifo_.empty())
+        break;
+      auto byte = hw_fifo_.front();
+      hw_fifo_.pop_front();
+      *rx_ptr_ = byte.second;
+      rx_ptr_ = nullptr;
+      stat_.rx_isr++;
+      rx_latency_.push_back(now_ - byte.first);
+      isr([this] { uart_isr_handle_rx(inst_); });
+      // data register still holds bytes, the irq fires again
+      schedule_rx_irq();
+      break;
+    }
+    case ev_tx_irq:
+      if (ev.gen != tx_gen_)
+        break;
+      isr([this] { uart_isr_handle_tx(inst_); });
+      break;
+    }
+  }
+
+  config cfg_;
+  std::mt19937 rng_;
+  uint64_t byte_ns_;
+  uart_io_t io_;
+  uart_t *inst_ = nullptr;
+  uint64_t now_ = 0;
+  uint64_t seq_ = 0;
+  uint64_t rx_line_free_ = 0;
+  uint64_t tx_line_free_ = 0;
+  uint64_t tx_gen_ = 0;
+  char *rx_ptr_ = nullptr;
+  bool rx_irq_pending_ = false;
+  std::deque<std::pair<uint64_t, char>> hw_fifo_;
+  std::priority_queue<event, std::vector<event>, std::greater<event>> events_;
+  std::vector<std::pair<uint64_t, char>> tx_log_;
+  std::vector<uint64_t> rx_latency_;
+  stat_t stat_;
+};
@@ -0,0 +1,255 @@
+/**
+ * @file capture.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "capture_utils.h"
+#include "uart_sim.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include "capture_replay.h"
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct record {
+  uint64_t time;
+  int dir;
+  int chan;
+  std::string data;
+  bool operator==(const record &o) const {
+    return time == o.time && dir == o.dir && chan == o.chan && data == o.data;
+  }
+};
+
+size_t string_sink(void *userdata, const void *data, size_t len) {
+  static_cast<std::string *>(userdata)->append(
+      static_cast<const char *>(data), len);
+  return len;
+}
+
+std::vector<record> parse(const std::string &file) {
+  std::vector<record> records;
+  capture_header_t header;
+  memcpy(&header, file.data(), sizeof(header));
+  EXPECT_EQ(header.magic, CAPTURE_MAGIC);
+  for (size_t pos = header.header_size; pos < file.size();) {
+    capture_record_t rec;
+    memcpy(&rec, file.data() + pos, sizeof(rec));
+    pos += sizeof(rec);
+    records.push_back(
+        {rec.time, rec.dir, rec.chan, file.substr(pos, rec.len)});
+    pos += rec.len;
+  }
+  return records;
+}
+
+} // namespace
+
+TEST(capture, write) {
+  char buf[64];
+  capture_t cap;
+  std::string file;
+
+  capture_init(&cap, buf, sizeof(buf), string_sink, &file, 1000);
+  capture_set_merge(&cap, 5);
+  capture_write(&cap, 0, capture_rx, 10, "ab", 2);
+  capture_write(&cap, 0, capture_rx, 11, "c", 1);
+  capture_write(&cap, 0, capture_tx, 12, "x", 1);
+  capture_write(&cap, 0, capture_rx, 100, "d", 1);
+  capture_write(&cap, 1, capture_rx, 101, "e", 1);
+  capture_flush(&cap);
+  ASSERT_EQ(parse(file), (std::vector<record>{{10, capture_rx, 0, "abc"},
+                                               {12, capture_tx, 0, "x"},
+                                               {100, capture_rx, 0, "d"},
+                                               {101, capture_rx, 1, "e"}}));
+
+  // records larger than the staging buffer are split over flushes
+  std::string big(200, 'z'), got;
+  file.clear();
+  capture_init(&cap, buf, sizeof(buf), string_sink, &file, 1000);
+  capture_write(&cap, 2, capture_tx, 7, big.data(), big.size());
+  capture_flush(&cap);
+  for (auto &r : parse(file)) {
+    ASSERT_EQ(r.time, 7);
+    ASSERT_EQ(r.chan, 2);
+    got += r.data;
+  }
+  ASSERT_EQ(got, big);
+  ASSERT_EQ(cap.dropped, 0);
+}
+
+#if UART_CAPTURE
+TEST(capture, uart_tap) {
+  char rx_buf[16], tx_buf[16], buf[256];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  capture_t cap;
+  std::string file, got_rx, got_tx;
+
+  capture_init(&cap, buf, sizeof(buf), string_sink, &file, 1);
+  capture_set_merge(&cap, UINT32_MAX);
+  sim.attach(&inst, &rx, &tx);
+  uart_set_capture(&inst, &cap, 3);
+  uart_write(&inst, "hi", 2);
+  sim.run();
+  uart_enable_rx(&inst);
+  sim.feed("yo", 2);
+  sim.run();
+  capture_flush(&cap);
+
+  size_t data_records = 0;
+  for (auto &r : parse(file)) {
+    // host ticks need the high bits as well
+    if (r.dir == capture_time)
+      continue;
+    data_records++;
+    ASSERT_EQ(r.chan, 3);
+    (r.dir == capture_rx ? got_rx : got_tx) += r.data;
+  }
+  ASSERT_EQ(data_records, 2);
+  ASSERT_EQ(got_tx, "hi");
+  ASSERT_EQ(got_rx, "yo");
+}
+#endif
+
+#ifdef __linux__
+namespace {
+// 'F' + 3 bytes
+extern "C" int match_capture(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if (c != 'F')
+    return -1;
+  return fifo_len(ptr) < 4 ? 0 : 4;
+}
+
+void collect(const char *frame, size_t len, utils_tick_t time,
+             void *userdata) {
+  static_cast<std::vector<record> *>(userdata)->push_back(
+      {uint64_t(time), 0, 0, std::string(frame, len)});
+}
+} // namespace
+
+TEST(capture, replay) {
+  char buf[64], rx_buf[16], frame[8];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+#if UART_RX_MARKS
+  uart_rx_mark_t mark_buf[4];
+  fifo_t marks = {4, sizeof(uart_rx_mark_t), 0, 0, mark_buf};
+#endif
+  capture_t cap;
+  capture_file_t cf;
+  std::string file, expect;
+  std::vector<record> frames;
+  char path[] = "/tmp/capture_replay_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+
+  capture_init(&cap, buf, sizeof(buf), string_sink, &file, 1);
+  // frames split over records, tx and other channels are skipped
+  capture_write(&cap, 0, capture_rx, 100, "zF12", 4);
+  capture_write(&cap, 0, capture_tx, 150, "F999", 4);
+  capture_write(&cap, 0, capture_rx, 200, "3F456F", 6);
+  capture_write(&cap, 1, capture_rx, 250, "F888", 4);
+  capture_write(&cap, 0, capture_rx, 300, "789", 3);
+  // more than the rx fifo holds
+  for (int i = 0; i < 8; i++)
+    capture_write(&cap, 0, capture_rx, 400 + i, "F000", 4);
+  capture_flush(&cap);
+  ASSERT_EQ(write(fd, file.data(), file.size()), file.size());
+  close(fd);
+
+  ASSERT_EQ(capture_open(&cf, path), 0);
+  capture_replay_t replay = {};
+  replay.fifo = &rx;
+#if UART_RX_MARKS
+  replay.marks = &marks;
+#endif
+  replay.match = match_capture;
+  replay.frame_buf = frame;
+  replay.frame_size = sizeof(frame);
+  ASSERT_EQ(capture_replay(&cf, 0, capture_rx, &replay, collect, &frames), 0);
+  capture_close(&cf);
+  unlink(path);
+
+  ASSERT_EQ(frames.size(), 11);
+#if UART_RX_MARKS
+  ASSERT_EQ(frames[0], (record{100, 0, 0, "F123"}));
+  ASSERT_EQ(frames[1], (record{200, 0, 0, "F456"}));
+  ASSERT_EQ(frames[2], (record{200, 0, 0, "F789"}));
+  for (int i = 0; i < 8; i++)
+    ASSERT_EQ(frames[3 + i], (record{uint32_t(400 + i), 0, 0, "F000"}));
+#else
+  // time of the record holding the last byte
+  ASSERT_EQ(frames[0], (record{200, 0, 0, "F123"}));
+  ASSERT_EQ(frames[1], (record{200, 0, 0, "F456"}));
+  ASSERT_EQ(frames[2], (record{300, 0, 0, "F789"}));
+  for (int i = 0; i < 8; i++)
+    ASSERT_EQ(frames[3 + i].data, "F000");
+#endif
+  ASSERT_EQ(replay.frames, 11);
+  ASSERT_EQ(replay.bytes, 4 + 6 + 3 + 8 * 4);
+  ASSERT_EQ(replay.stalled, 0);
+}
+
+TEST(capture, replay_wrap) {
+  char buf[64], rx_buf[16], frame[8];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+#if UART_RX_MARKS
+  uart_rx_mark_t mark_buf[4];
+  fifo_t marks = {4, sizeof(uart_rx_mark_t), 0, 0, mark_buf};
+#endif
+  capture_t cap;
+  capture_file_t cf;
+  std::string file;
+  std::vector<record> frames;
+  char path[] = "/tmp/capture_replay_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+
+  // 64-bit ticks crossing the 32-bit wrap, then a gap of several wraps
+  capture_init(&cap, buf, sizeof(buf), string_sink, &file, 1);
+  capture_write(&cap, 0, capture_rx, 0xfffffff0ull, "F1", 2);
+  capture_write(&cap, 0, capture_rx, 0x100000010ull, "23", 2);
+  capture_write(&cap, 0, capture_rx, 0x500000000ull, "F456", 4);
+  capture_flush(&cap);
+  int time_records = 0;
+  for (auto &r : parse(file))
+    time_records += r.dir == capture_time;
+  ASSERT_EQ(time_records, 2);
+  ASSERT_EQ(write(fd, file.data(), file.size()), file.size());
+  close(fd);
+
+  ASSERT_EQ(capture_open(&cf, path), 0);
+  capture_replay_t replay = {};
+  replay.fifo = &rx;
+#if UART_RX_MARKS
+  replay.marks = &marks;
+#endif
+  replay.match = match_capture;
+  replay.frame_buf = frame;
+  replay.frame_size = sizeof(frame);
+  ASSERT_EQ(capture_replay(&cf, 0, capture_rx, &replay, collect, &frames), 0);
+  capture_close(&cf);
+  unlink(path);
+
+  ASSERT_EQ(frames.size(), 2);
+#if UART_RX_MARKS
+  ASSERT_EQ(frames[0], (record{0xfffffff0ull, 0, 0, "F123"}));
+#else
+  ASSERT_EQ(frames[0], (record{0x100000010ull, 0, 0, "F123"}));
+#endif
+  ASSERT_EQ(frames[1], (record{0x500000000ull, 0, 0, "F456"}));
+}
+#endif
@@ -105,3 +105,33 @@ TEST(fifo, simple_io_4) {
 
   ASSERT_EQ(fifo_len(ptr), 127);
 }
+
+TEST(fifo, reserve_commit) {
+  FIFO_DEFINE(c, 16, int);
+  fifo_t *ptr = FIFO_PTR(c);
+  int *p;
+
+  for (int i = 0; i < 10; i++)
+    fifo_push(ptr, &i, 1);
+  for (int i = 0; i < 10; i++) {
+    int t;
+    fifo_pop(ptr, &t, 1);
+  }
+
+  // contiguous part ends at the buffer end
+  ASSERT_EQ(fifo_reserve(ptr, (void **)&p), 6);
+  for (int i = 0; i < 6; i++)
+    p[i] = i;
+  fifo_commit(ptr, 6);
+  ASSERT_EQ(fifo_len(ptr), 6);
+  ASSERT_EQ(fifo_reserve(ptr, (void **)&p), 9);
+  p[0] = 6;
+  fifo_commit(ptr, 1);
+
+  for (int i = 0; i < 7; i++) {
+    int t;
+    fifo_pop(ptr, &t, 1);
+    ASSERT_EQ(t, i);
+  }
+  ASSERT_EQ(fifo_len(ptr), 0);
+}
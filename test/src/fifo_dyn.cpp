@@ -0,0 +1,86 @@
+/**
+ * @file fifo_dyn.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+#include "fifo_dyn.h"
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(fifo_dyn, grow) {
+  fifo_dyn_t dyn;
+  uint32_t next_in = 0, next_out = 0, v;
+
+  ASSERT_EQ(fifo_dyn_init(&dyn, sizeof(uint32_t), 4, 1 << 12, false), 0);
+  // wrap the small buffer before it grows
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(fifo_dyn_push(&dyn, &next_in, 1), 1);
+    next_in++;
+  }
+  ASSERT_EQ(fifo_dyn_pop(&dyn, &v, 1), 1);
+  ASSERT_EQ(v, next_out++);
+  ASSERT_EQ(fifo_dyn_push(&dyn, &next_in, 1), 1);
+  next_in++;
+  ASSERT_EQ(dyn.fifo.index_end, 0);
+
+  std::vector<uint32_t> in(1000);
+  for (auto &x : in)
+    x = next_in++;
+  ASSERT_EQ(fifo_dyn_push(&dyn, in.data(), in.size()), in.size());
+  ASSERT_EQ(dyn.fifo.fifo_len, 1024);
+  ASSERT_EQ(dyn.grows, 1);
+
+  // plain fifo_t api on the grown buffer
+  ASSERT_EQ(fifo_len(&dyn.fifo), next_in - next_out);
+  fifo_peek(&dyn.fifo, 10, &v);
+  ASSERT_EQ(v, next_out + 10);
+  while (fifo_len(&dyn.fifo)) {
+    fifo_pop(&dyn.fifo, &v, 1);
+    ASSERT_EQ(v, next_out++);
+  }
+  ASSERT_EQ(next_out, next_in);
+  fifo_dyn_deinit(&dyn);
+}
+
+TEST(fifo_dyn, max_len) {
+  fifo_dyn_t dyn;
+  char buf[100] = {};
+
+  ASSERT_EQ(fifo_dyn_init(&dyn, 1, 16, 64, false), 0);
+  ASSERT_EQ(fifo_dyn_grow(&dyn, 63), 0);
+  ASSERT_EQ(fifo_dyn_grow(&dyn, 64), -ENOSPC);
+  ASSERT_EQ(fifo_dyn_push(&dyn, buf, sizeof(buf)), 63);
+  ASSERT_EQ(fifo_dyn_push(&dyn, buf, 1), 0);
+  ASSERT_EQ(dyn.fifo.fifo_len, 64);
+  fifo_dyn_deinit(&dyn);
+}
+
+TEST(fifo_dyn, shrink) {
+  fifo_dyn_t dyn;
+  std::vector<uint16_t> in(4000), out(4000);
+
+  for (size_t i = 0; i < in.size(); i++)
+    in[i] = i;
+  ASSERT_EQ(fifo_dyn_init(&dyn, sizeof(uint16_t), 8, 1 << 16, true), 0);
+  ASSERT_EQ(fifo_dyn_push(&dyn, in.data(), in.size()), in.size());
+  ASSERT_EQ(dyn.fifo.fifo_len, 4096);
+
+  // a quarter full still keeps the buffer
+  ASSERT_EQ(fifo_dyn_pop(&dyn, out.data(), 2976), 2976);
+  ASSERT_EQ(dyn.fifo.fifo_len, 4096);
+  ASSERT_EQ(fifo_dyn_pop(&dyn, out.data() + 2976, 1000), 1000);
+  ASSERT_EQ(dyn.fifo.fifo_len, 64);
+  ASSERT_EQ(dyn.shrinks, 1);
+  ASSERT_EQ(fifo_dyn_pop(&dyn, out.data() + 3976, 100), 24);
+  ASSERT_EQ(dyn.fifo.fifo_len, 8);
+  ASSERT_EQ(in, out);
+  fifo_dyn_deinit(&dyn);
+}
+#endif
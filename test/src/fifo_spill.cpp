@@ -0,0 +1,142 @@
+/**
+ * @file fifo_spill.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+#include "fifo_spill.h"
+#include <dirent.h>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+// open fds of spill files
+int spill_fds() {
+  DIR *dir = opendir("/proc/self/fd");
+  int num = 0;
+  char link[256];
+  while (auto ent = readdir(dir)) {
+    std::string path = std::string("/proc/self/fd/") + ent->d_name;
+    ssize_t n = readlink(path.c_str(), link, sizeof(link) - 1);
+    if (n > 0 && std::string(link, n).find("fifo_spill_") != std::string::npos)
+      num++;
+  }
+  closedir(dir);
+  return num;
+}
+
+// mappings of spill files
+int spill_maps() {
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  int num = 0;
+  while (std::getline(maps, line))
+    num += line.find("fifo_spill_") != std::string::npos;
+  return num;
+}
+} // namespace
+
+TEST(fifo_spill, order) {
+  uint32_t buf[16], out[64];
+  fifo_t fifo = {16, sizeof(uint32_t), 0, 0, buf};
+  fifo_spill_t spill;
+  uint32_t next_in = 0, next_out = 0;
+
+  // 4096 byte segments hold 1024 items
+  fifo_spill_init(&spill, &fifo, "/tmp", 8, 4096);
+  for (int round = 0; round < 3; round++) {
+    // a stalled consumer, the burst goes to disk
+    for (int i = 0; i < 100; i++) {
+      std::vector<uint32_t> in(50);
+      for (auto &v : in)
+        v = next_in++;
+      ASSERT_EQ(fifo_spill_push(&spill, in.data(), in.size()), in.size());
+    }
+    ASSERT_LE(fifo_len(&fifo), 8);
+    ASSERT_EQ(fifo_spill_len(&spill), next_in - next_out);
+    // drain
+    size_t n;
+    while ((n = fifo_spill_pop(&spill, out, 64))) {
+      for (size_t i = 0; i < n; i++)
+        ASSERT_EQ(out[i], next_out++);
+    }
+    ASSERT_EQ(next_out, next_in);
+  }
+  ASSERT_GT(spill.spilled, 0);
+
+  // drained, the ring is used again
+  uint64_t spilled = spill.spilled;
+  ASSERT_EQ(fifo_spill_push(&spill, &next_in, 1), 1);
+  ASSERT_EQ(spill.spilled, spilled);
+  ASSERT_EQ(fifo_len(&fifo), 1);
+  fifo_spill_deinit(&spill);
+}
+
+TEST(fifo_spill, threads) {
+  static uint32_t buf[256];
+  fifo_t fifo = {256, sizeof(uint32_t), 0, 0, buf};
+  fifo_spill_t spill;
+  const uint32_t total = 1 << 20;
+  bool ok = true;
+
+  fifo_spill_init(&spill, &fifo, "/tmp", 192, 1 << 16);
+  std::thread consumer([&] {
+    uint32_t out[100], expect = 0;
+    while (expect < total) {
+      size_t n = fifo_spill_pop(&spill, out, 100);
+      for (size_t i = 0; i < n; i++)
+        ok &= out[i] == expect++;
+      if (!n)
+        std::this_thread::yield();
+    }
+  });
+  uint32_t in[37];
+  for (uint32_t v = 0; v < total;) {
+    size_t n = 0;
+    for (; n < 37 && v < total; n++)
+      in[n] = v++;
+    ASSERT_EQ(fifo_spill_push(&spill, in, n), n);
+  }
+  consumer.join();
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(fifo_spill_len(&spill), 0);
+  fifo_spill_deinit(&spill);
+}
+TEST(fifo_spill, resources) {
+  uint32_t buf[16], out[64];
+  fifo_t fifo = {16, sizeof(uint32_t), 0, 0, buf};
+  fifo_spill_t spill;
+  uint32_t next_in = 0, next_out = 0;
+
+  // 1024 items per segment, a burst of 128 segments
+  fifo_spill_init(&spill, &fifo, "/tmp", 8, 4096);
+  for (int i = 0; i < 128 * 1024 / 64; i++) {
+    uint32_t in[64];
+    for (auto &v : in)
+      v = next_in++;
+    ASSERT_EQ(fifo_spill_push(&spill, in, 64), 64);
+    ASSERT_LE(spill_maps(), 1);
+  }
+  ASSERT_EQ(spill_fds(), 1);
+  size_t n;
+  while ((n = fifo_spill_pop(&spill, out, 64))) {
+    for (size_t i = 0; i < n; i++)
+      ASSERT_EQ(out[i], next_out++);
+    ASSERT_LE(spill_maps(), 2);
+  }
+  ASSERT_EQ(next_out, next_in);
+  ASSERT_EQ(spill_fds(), 1);
+  fifo_spill_deinit(&spill);
+  ASSERT_EQ(spill_fds(), 0);
+  ASSERT_EQ(spill_maps(), 0);
+}
+#endif
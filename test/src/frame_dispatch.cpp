@@ -0,0 +1,110 @@
+/**
+ * @file frame_dispatch.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+#include "frame_dispatch.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <vector>
+
+namespace {
+
+const int keys = 16;
+
+struct order_check {
+  uint32_t next[keys] = {};
+  std::atomic<int> worker_of[keys];
+  std::atomic<int> errors{0};
+  order_check() {
+    for (auto &w : worker_of)
+      w = -1;
+  }
+};
+
+extern "C" void on_dispatch(unsigned worker, uint32_t key, frame_t *frame,
+                            void *userdata) {
+  auto check = static_cast<order_check *>(userdata);
+  uint32_t seq;
+  int expect = -1;
+
+  memcpy(&seq, frame->data, sizeof(seq));
+  // a key sticks to one worker, so next[key] has a single writer
+  if (!check->worker_of[key].compare_exchange_strong(expect, int(worker)) &&
+      expect != int(worker))
+    check->errors++;
+  if (seq != check->next[key])
+    check->errors++;
+  check->next[key] = seq + 1;
+}
+
+} // namespace
+
+TEST(frame_dispatch, order) {
+  static frame_t frames[64];
+  static char pool_buf[64 * sizeof(uint32_t)];
+  frame_dispatch_worker_t workers[4];
+  frame_dispatch_item_t items[4 * 8];
+  frame_dispatch_t dispatch;
+  frame_pool_t pool;
+  order_check check;
+  uint32_t seq[keys] = {};
+
+  frame_pool_init(&pool, frames, pool_buf, 64, sizeof(uint32_t));
+  ASSERT_EQ(frame_dispatch_init(&dispatch, workers, 4, items, 8, on_dispatch,
+                                &check),
+            0);
+  for (int i = 0; i < 20000; i++) {
+    uint32_t key = i * 7 % keys;
+    frame_t *f;
+    while (!(f = frame_alloc(&pool)))
+      sched_yield();
+    memcpy(f->data, &seq[key], sizeof(uint32_t));
+    f->len = sizeof(uint32_t);
+    seq[key]++;
+    while (frame_dispatch_post(&dispatch, key, f) == -EAGAIN)
+      sched_yield();
+  }
+  frame_dispatch_deinit(&dispatch);
+
+  ASSERT_EQ(check.errors, 0);
+  for (int k = 0; k < keys; k++)
+    ASSERT_EQ(check.next[k], seq[k]);
+  ASSERT_EQ(frame_pool_available(&pool), 64);
+
+  uint64_t handled = 0;
+  for (unsigned w = 0; w < 4; w++) {
+    frame_dispatch_stats_t st;
+    frame_dispatch_stats(&dispatch, w, &st);
+    ASSERT_EQ(st.depth, 0);
+    ASSERT_EQ(st.posted, st.handled);
+    ASSERT_LE(st.max_depth, 7);
+    handled += st.handled;
+  }
+  ASSERT_EQ(handled, 20000);
+}
+TEST(frame_dispatch, spread) {
+  frame_dispatch_t dispatch = {};
+
+  // aligned ids must not pile up on one worker
+  for (unsigned count : {2u, 4u, 6u, 8u}) {
+    dispatch.count = count;
+    for (uint32_t stride : {1u, 8u, 64u, 4096u}) {
+      std::vector<int> hits(count);
+      for (uint32_t i = 0; i < 1024; i++)
+        hits[frame_dispatch_worker(&dispatch, i * stride)]++;
+      for (int h : hits)
+        ASSERT_GT(h, 1024 / int(count) / 2) << count << " " << stride;
+    }
+  }
+}
+#endif
@@ -0,0 +1,128 @@
+/**
+ * @file pool.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include <gtest/gtest.h>
+#include <pool_utils.h>
+#include <protocal_utils.h>
+#include <atomic>
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+FRAME_POOL_DEFINE(test, 4, 8);
+
+TEST(pool, alloc_free) {
+  std::set<frame_t *> frames;
+
+  FRAME_POOL_INIT(test, 4, 8);
+  ASSERT_EQ(frame_pool_available(FRAME_POOL_PTR(test)), 4);
+  for (int i = 0; i < 4; i++) {
+    frame_t *f = frame_alloc(FRAME_POOL_PTR(test));
+    ASSERT_NE(f, nullptr);
+    ASSERT_EQ(f->len, 0);
+    frames.insert(f);
+  }
+  ASSERT_EQ(frames.size(), 4);
+  ASSERT_EQ(frame_alloc(FRAME_POOL_PTR(test)), nullptr);
+  ASSERT_EQ(frame_pool_available(FRAME_POOL_PTR(test)), 0);
+  for (auto f : frames)
+    frame_unref(f);
+  ASSERT_EQ(frame_pool_available(FRAME_POOL_PTR(test)), 4);
+}
+
+TEST(pool, fanout) {
+  FRAME_POOL_INIT(test, 4, 8);
+  frame_t *f = frame_alloc(FRAME_POOL_PTR(test));
+
+  // logger and router hold the same bytes
+  frame_t *logger = frame_ref(f), *router = frame_ref(f);
+  ASSERT_EQ(logger->data, router->data);
+  frame_unref(f);
+  frame_unref(logger);
+  ASSERT_EQ(frame_pool_available(FRAME_POOL_PTR(test)), 3);
+  frame_unref(router);
+  ASSERT_EQ(frame_pool_available(FRAME_POOL_PTR(test)), 4);
+}
+
+// 'P' + 3 bytes
+extern "C" int match_pool(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if (c != 'P')
+    return -1;
+  return fifo_len(ptr) < 4 ? 0 : 4;
+}
+
+TEST(pool, find_frame) {
+  FIFO_DEFINE(c, 32, char);
+  fifo_t *ptr = FIFO_PTR(c);
+  frame_pool_t *pool = FRAME_POOL_PTR(test);
+  std::vector<frame_t *> frames;
+
+  FRAME_POOL_INIT(test, 4, 8);
+  fifo_push(ptr, "xP123P456P789P000P111P2", 23);
+  while (fifo_len(ptr)) {
+    size_t len = fifo_len(ptr);
+    frame_t *f = protocal_find_frame_pool(ptr, match_pool, pool);
+    if (f)
+      frames.push_back(f);
+    else if (fifo_len(ptr) == len)
+      break;
+  }
+  // pool exhausted, the rest waits in the fifo
+  ASSERT_EQ(frames.size(), 4);
+  ASSERT_EQ(std::string(frames[0]->data, frames[0]->len), "P123");
+  ASSERT_EQ(std::string(frames[3]->data, frames[3]->len), "P000");
+  ASSERT_EQ(fifo_len(ptr), 6);
+
+  frame_unref(frames[0]);
+  frame_t *f = protocal_find_frame_pool(ptr, match_pool, pool);
+  ASSERT_NE(f, nullptr);
+  ASSERT_EQ(std::string(f->data, f->len), "P111");
+  ASSERT_EQ(protocal_find_frame_pool(ptr, match_pool, pool), nullptr);
+  ASSERT_EQ(fifo_len(ptr), 2);
+}
+
+TEST(pool, threads) {
+  static frame_t frames[8];
+  static char buffer[8 * sizeof(int)];
+  frame_pool_t pool;
+  std::vector<std::thread> threads;
+  std::atomic<int> errors{0};
+
+  frame_pool_init(&pool, frames, buffer, 8, sizeof(int));
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 20000; i++) {
+        frame_t *f = frame_alloc(&pool);
+        if (!f) {
+          std::this_thread::yield();
+          continue;
+        }
+        // nobody else may own the frame now
+        memcpy(f->data, &t, sizeof(t));
+        frame_t *copy = frame_ref(f);
+        std::this_thread::yield();
+        int got;
+        memcpy(&got, copy->data, sizeof(got));
+        if (got != t)
+          errors++;
+        frame_unref(f);
+        frame_unref(copy);
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  ASSERT_EQ(errors, 0);
+  ASSERT_EQ(frame_pool_available(&pool), 8);
+}
@@ -1,10 +1,33 @@
+#include "uart_sim.h"
 #include <gtest/gtest.h>
-#include <protocal_utils.h>
+#include <protocal_uart.h>
+#include <string>
 #include <vector>
 
 extern "C" int match_all(fifo_t *ptr) { return fifo_len(ptr); }
 extern "C" int match_deny(fifo_t *ptr) { return 0; }
 
+// 'F' + 3 bytes
+extern "C" int match_f4(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if (c != 'F')
+    return -1;
+  return fifo_len(ptr) < 4 ? 0 : 4;
+}
+
+// 'L' + len + payload[len]
+extern "C" int match_lv(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if (c != 'L')
+    return -1;
+  if (fifo_len(ptr) < 2)
+    return 0;
+  fifo_peek(ptr, 1, &c);
+  return fifo_len(ptr) < (size_t)c + 2 ? 0 : c + 2;
+}
+
 TEST(protocal, protocal_find_1) {
 
   FIFO_DEFINE(c, 128, char);
@@ -43,4 +66,297 @@ TEST(protocal, protocal_find_2) {
         ASSERT_EQ(t, buf_org[i + 1]);
     }
   }
-}
\ No newline at end of file
+}
+#if UART_RX_MARKS
+TEST(protocal, protocal_find_ts) {
+  char rx_buf[64], tx_buf[16], buf[16];
+  uart_rx_mark_t mark_buf[8];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  fifo_t marks = {8, sizeof(uart_rx_mark_t), 0, 0, mark_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  protocal_ts_t ts;
+  utils_tick_t time;
+  std::vector<std::string> frames;
+  std::vector<utils_tick_t> times;
+
+  sim.attach(&inst, &rx, &tx);
+  uart_set_rx_marks(&inst, &marks, 0);
+  protocal_ts_init(&ts, &marks);
+  uart_enable_rx(&inst);
+
+  // chunk based backend, one mark per chunk
+  const char *chunks[] = {"zzF12", "3F45", "6F789"};
+  for (int i = 0; i < 3; i++) {
+    uart_rx_mark(&inst, 100 * (i + 1));
+    sim.feed(chunks[i], strlen(chunks[i]));
+    sim.run();
+  }
+  ASSERT_EQ(fifo_len(&marks), 3);
+  for (int re; fifo_len(&rx);) {
+    re = protocal_find_frame_ts(&rx, match_f4, buf, sizeof(buf), &ts, &time);
+    if (re > 0) {
+      frames.emplace_back(buf, re);
+      times.push_back(time);
+    }
+  }
+  ASSERT_EQ(frames, (std::vector<std::string>{"F123", "F456", "F789"}));
+  ASSERT_EQ(times, (std::vector<utils_tick_t>{100, 200, 300}));
+  ASSERT_EQ(fifo_len(&marks), 0);
+
+  // byte isr: mark on empty fifo, then every interval bytes
+  uart_set_rx_marks(&inst, &marks, 4);
+  sim.feed("0123456789", 10);
+  sim.run();
+  ASSERT_EQ(fifo_len(&marks), 3);
+  size_t head = rx.index_start;
+  for (size_t i = 0; i < 3; i++) {
+    uart_rx_mark_t m;
+    fifo_pop(&marks, &m, 1);
+    ASSERT_EQ(m.index, (head + i * 4) & (sizeof(rx_buf) - 1));
+  }
+}
+#endif
+
+TEST(protocal, stream_byte_timeout) {
+  FIFO_DEFINE(c, 32, char);
+  fifo_t *ptr = FIFO_PTR(c);
+  timer_node_t slots[16];
+  timer_wheel_t wheel;
+  protocal_stream_t stream;
+  char buf[16];
+
+  timer_wheel_init(&wheel, slots, 16, 0, 0);
+  protocal_stream_init(&stream, ptr, match_f4, &wheel, 5, 0);
+
+  // truncated frame, then the line goes quiet
+  fifo_push(ptr, "F1", 2);
+  ASSERT_EQ(protocal_stream_find(&stream, buf, sizeof(buf)), 0);
+  timer_wheel_advance(&wheel, 4);
+  ASSERT_EQ(fifo_len(ptr), 2);
+  timer_wheel_advance(&wheel, 5);
+  ASSERT_EQ(fifo_len(ptr), 0);
+  ASSERT_EQ(stream.expired, 1);
+  ASSERT_EQ(stream.dropped, 2);
+
+  // the next frame is not glued to the stale bytes
+  fifo_push(ptr, "F234", 4);
+  ASSERT_EQ(protocal_stream_find(&stream, buf, sizeof(buf)), 4);
+  ASSERT_EQ(std::string(buf, 4), "F234");
+  protocal_stream_deinit(&stream);
+}
+
+TEST(protocal, stream_byte_timeout_keeps_frames) {
+  FIFO_DEFINE(c, 32, char);
+  fifo_t *ptr = FIFO_PTR(c);
+  timer_node_t slots[16];
+  timer_wheel_t wheel;
+  protocal_stream_t stream;
+  char buf[16];
+  const char wire[] = {'L', 9, 'a', 'b', 'L', 2, 'c', 'd'};
+
+  timer_wheel_init(&wheel, slots, 16, 0, 0);
+  protocal_stream_init(&stream, ptr, match_lv, &wheel, 5, 0);
+
+  // a truncated frame swallows the complete one behind it
+  fifo_push(ptr, wire, sizeof(wire));
+  ASSERT_EQ(protocal_stream_find(&stream, buf, sizeof(buf)), 0);
+  timer_wheel_advance(&wheel, 5);
+  ASSERT_EQ(stream.expired, 1);
+  ASSERT_EQ(stream.dropped, 4);
+  ASSERT_FALSE(timer_pending(&stream.timer));
+  ASSERT_EQ(protocal_stream_find(&stream, buf, sizeof(buf)), 4);
+  ASSERT_EQ(std::string(buf, 4), std::string(wire + 4, 4));
+  ASSERT_EQ(fifo_len(ptr), 0);
+  protocal_stream_deinit(&stream);
+}
+
+TEST(protocal, stream_frame_timeout) {
+  FIFO_DEFINE(c, 32, char);
+  fifo_t *ptr = FIFO_PTR(c);
+  timer_node_t slots[16];
+  timer_wheel_t wheel;
+  protocal_stream_t stream;
+  char buf[16];
+  int frames = 0;
+
+  timer_wheel_init(&wheel, slots, 16, 0, 0);
+  protocal_stream_init(&stream, ptr, match_f4, &wheel, 5, 8);
+
+  // bytes keep coming but the head frame never completes in time
+  fifo_push(ptr, "F", 1);
+  for (utils_tick_t t = 0; t < 8; t += 4) {
+    timer_wheel_advance(&wheel, t);
+    ASSERT_EQ(protocal_stream_find(&stream, buf, sizeof(buf)), 0);
+  }
+  fifo_push(ptr, "F9", 2); // the first 'F' was lost on the wire
+  timer_wheel_advance(&wheel, 8);
+  ASSERT_EQ(stream.expired, 1);
+  ASSERT_EQ(stream.dropped, 1);
+  fifo_push(ptr, "99", 2);
+  while (protocal_stream_find(&stream, buf, sizeof(buf)) > 0)
+    frames++;
+  ASSERT_EQ(frames, 1);
+  ASSERT_EQ(std::string(buf, 4), "F999");
+  ASSERT_FALSE(timer_pending(&stream.timer));
+}
+
+TEST(protocal, stream_resync) {
+  FIFO_DEFINE(c, 32, char);
+  fifo_t *ptr = FIFO_PTR(c);
+  timer_node_t slots[16];
+  timer_wheel_t wheel;
+  protocal_stream_t stream;
+  char buf[16], head;
+
+  timer_wheel_init(&wheel, slots, 16, 0, 0);
+  protocal_stream_init(&stream, ptr, match_f4, &wheel, 0, 8);
+
+  fifo_push(ptr, "FxF", 3);
+  ASSERT_EQ(protocal_stream_find(&stream, buf, sizeof(buf)), 0);
+  // the stale 'F' goes, the matcher skips 'x' and waits on the next 'F'
+  // without another protocal_stream_find
+  timer_wheel_advance(&wheel, 8);
+  ASSERT_EQ(fifo_len(ptr), 1);
+  fifo_peek(ptr, 0, &head);
+  ASSERT_EQ(head, 'F');
+  ASSERT_TRUE(timer_pending(&stream.timer));
+  ASSERT_EQ(stream.dropped, 1);
+  // and times out on its own as well
+  timer_wheel_advance(&wheel, 16);
+  ASSERT_EQ(fifo_len(ptr), 0);
+  ASSERT_EQ(stream.expired, 2);
+  ASSERT_FALSE(timer_pending(&stream.timer));
+}
+
+namespace {
+std::string cobs_decode(const std::string &in) {
+  std::string out;
+  size_t i = 0;
+  while (i < in.size() && in[i]) {
+    uint8_t code = in[i++];
+    out.append(in, i, code - 1);
+    i += code - 1;
+    if (code < 0xFF && i < in.size() && in[i])
+      out += '\0';
+  }
+  return out;
+}
+
+std::string slip_decode(const std::string &in) {
+  std::string out;
+  for (size_t i = 1; i + 1 < in.size(); i++) {
+    if (in[i] == '\xDB')
+      out += in[++i] == '\xDC' ? '\xC0' : '\xDB';
+    else
+      out += in[i];
+  }
+  return out;
+}
+
+std::string fifo_string(fifo_t *fifo) {
+  std::string s(fifo_len(fifo), 0);
+  fifo_pop(fifo, &s[0], s.size());
+  return s;
+}
+} // namespace
+
+TEST(protocal, enc_cobs) {
+  char buf[1024];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+  protocal_enc_t enc;
+  std::string payload;
+
+  for (int i = 0; i < 600; i++)
+    payload += char(i % 7 ? i : 0);
+  // a run of 254 non zero bytes fills a whole block
+  payload += std::string(300, 'x');
+  for (size_t len : {size_t(0), size_t(1), size_t(254), payload.size()}) {
+    // start near the end of the buffer to wrap inside the frame
+    fifo.index_start = fifo.index_end = sizeof(buf) - 5;
+    std::string p = payload.substr(0, len);
+    ASSERT_TRUE(protocal_enc_begin(&enc, &fifo, protocal_enc_cobs, len));
+    protocal_enc_write(&enc, p.data(), p.size() / 2);
+    ASSERT_EQ(fifo_len(&fifo), 0);
+    protocal_enc_write(&enc, p.data() + p.size() / 2, p.size() - p.size() / 2);
+    size_t n = protocal_enc_end(&enc);
+    ASSERT_LE(n, protocal_enc_size(protocal_enc_cobs, len));
+    std::string frame = fifo_string(&fifo);
+    ASSERT_EQ(frame.size(), n);
+    ASSERT_EQ(frame.find('\0'), n - 1);
+    ASSERT_EQ(cobs_decode(frame), p);
+  }
+}
+
+TEST(protocal, enc_slip) {
+  char buf[64];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+  protocal_enc_t enc;
+  const std::string payload("a\xC0" "b\xDB" "c", 5);
+
+  ASSERT_TRUE(protocal_enc_begin(&enc, &fifo, protocal_enc_slip, 5));
+  protocal_enc_write(&enc, payload.data(), payload.size());
+  ASSERT_EQ(protocal_enc_end(&enc), 9);
+  std::string frame = fifo_string(&fifo);
+  ASSERT_EQ(frame, std::string("\xC0" "a\xDB\xDC" "b\xDB\xDD" "c\xC0", 9));
+  ASSERT_EQ(slip_decode(frame), payload);
+}
+
+TEST(protocal, enc_len_crc) {
+  char buf[32];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+  protocal_enc_t enc;
+
+  ASSERT_EQ(protocal_crc16(0xFFFF, "123456789", 9), 0x29B1);
+  // worst case does not fit, nothing reserved
+  ASSERT_FALSE(protocal_enc_begin(&enc, &fifo, protocal_enc_len_crc, 28));
+  ASSERT_TRUE(protocal_enc_begin(&enc, &fifo, protocal_enc_len_crc, 27));
+  protocal_enc_write(&enc, "123456789", 9);
+  ASSERT_EQ(protocal_enc_end(&enc), 13);
+  ASSERT_EQ(fifo_string(&fifo),
+            std::string("\x09\x00" "123456789" "\xB1\x29", 13));
+
+  // abort leaves fifo untouched
+  ASSERT_TRUE(protocal_enc_begin(&enc, &fifo, protocal_enc_len_crc, 4));
+  protocal_enc_write(&enc, "abcd", 4);
+  protocal_enc_abort(&enc);
+  ASSERT_EQ(fifo_len(&fifo), 0);
+
+  // a length field can't describe more
+  ASSERT_FALSE(protocal_enc_begin(&enc, &fifo, protocal_enc_len_crc,
+                                  UINT16_MAX + 1));
+}
+
+TEST(protocal, enc_max_payload) {
+  char buf[32];
+  fifo_t fifo = {sizeof(buf), 1, 0, 0, buf};
+  protocal_enc_t enc;
+
+  // the slip worst case of 4 bytes is 10, more than 4 would overrun it
+  ASSERT_TRUE(protocal_enc_begin(&enc, &fifo, protocal_enc_slip, 4));
+  ASSERT_EQ(protocal_enc_write(&enc, "\xC0\xC0\xC0", 3), 3);
+  ASSERT_EQ(protocal_enc_write(&enc, "\xC0\xC0\xC0", 3), 1);
+  ASSERT_EQ(protocal_enc_write(&enc, "x", 1), 0);
+  ASSERT_EQ(protocal_enc_end(&enc), 10);
+  ASSERT_EQ(slip_decode(fifo_string(&fifo)), std::string(4, '\xC0'));
+}
+
+TEST(protocal, enc_uart) {
+  char rx_buf[16], tx_buf[64];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  protocal_enc_t enc;
+  std::string sent;
+
+  sim.attach(&inst, &rx, &tx);
+  ASSERT_TRUE(protocal_enc_begin(&enc, inst.tx_fifo, protocal_enc_cobs, 8));
+  protocal_enc_write(&enc, "ab\0cd", 5);
+  ASSERT_EQ(protocal_enc_end_uart(&enc, &inst), 7);
+  sim.run();
+  for (auto &b : sim.tx_log())
+    sent += b.second;
+  ASSERT_EQ(sent, std::string("\x03" "ab\x03" "cd\0", 7));
+}
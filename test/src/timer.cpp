@@ -0,0 +1,108 @@
+/**
+ * @file timer.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include <gtest/gtest.h>
+#include <timer_utils.h>
+#include <vector>
+
+namespace {
+
+struct test_timer {
+  timer_node_t node; // first member
+  int id;
+  std::vector<std::pair<int, utils_tick_t>> *log;
+  timer_wheel_t *wheel;
+};
+
+extern "C" void on_test_timer(timer_node_t *node) {
+  auto t = reinterpret_cast<test_timer *>(node);
+  t->log->emplace_back(t->id, t->wheel->now);
+}
+
+} // namespace
+
+TEST(timer, fire) {
+  timer_node_t slots[8];
+  timer_wheel_t wheel;
+  std::vector<std::pair<int, utils_tick_t>> log;
+  test_timer t[4];
+
+  timer_wheel_init(&wheel, slots, 8, 1, 100);
+  for (int i = 0; i < 4; i++) {
+    t[i] = {{}, i, &log, &wheel};
+    timer_init(&t[i].node, on_test_timer);
+  }
+  timer_add(&wheel, &t[0].node, 103);
+  timer_add(&wheel, &t[1].node, 105);
+  timer_add(&wheel, &t[2].node, 100 + 40); // more than one turn away
+  timer_add(&wheel, &t[3].node, 50);       // already due
+  ASSERT_EQ(timer_wheel_advance(&wheel, 100), 1);
+  ASSERT_EQ(timer_wheel_advance(&wheel, 102), 0);
+  ASSERT_EQ(timer_wheel_advance(&wheel, 110), 2);
+  ASSERT_TRUE(timer_pending(&t[2].node));
+  ASSERT_EQ(timer_wheel_advance(&wheel, 139), 0);
+  ASSERT_EQ(timer_wheel_advance(&wheel, 1000), 1);
+  ASSERT_FALSE(timer_pending(&t[2].node));
+  ASSERT_EQ(log, (std::vector<std::pair<int, utils_tick_t>>{
+                     {3, 100}, {0, 110}, {1, 110}, {2, 1000}}));
+}
+
+TEST(timer, cancel_move) {
+  timer_node_t slots[4];
+  timer_wheel_t wheel;
+  std::vector<std::pair<int, utils_tick_t>> log;
+  test_timer t[2];
+
+  timer_wheel_init(&wheel, slots, 4, 0, 0);
+  for (int i = 0; i < 2; i++) {
+    t[i] = {{}, i, &log, &wheel};
+    timer_init(&t[i].node, on_test_timer);
+  }
+  timer_add(&wheel, &t[0].node, 2);
+  timer_add(&wheel, &t[1].node, 2);
+  timer_cancel(&t[0].node);
+  timer_cancel(&t[0].node);
+  timer_add(&wheel, &t[1].node, 3);
+  ASSERT_EQ(timer_wheel_advance(&wheel, 2), 0);
+  ASSERT_EQ(timer_wheel_advance(&wheel, 3), 1);
+  ASSERT_EQ(log, (std::vector<std::pair<int, utils_tick_t>>{{1, 3}}));
+}
+
+TEST(timer, wrap) {
+  timer_node_t slots[16];
+  timer_wheel_t wheel;
+  std::vector<std::pair<int, utils_tick_t>> log;
+  test_timer t = {{}, 7, &log, &wheel};
+  utils_tick_t start = utils_tick_t(-5);
+
+  timer_wheel_init(&wheel, slots, 16, 0, start);
+  timer_init(&t.node, on_test_timer);
+  timer_add(&wheel, &t.node, start + 10);
+  ASSERT_EQ(timer_wheel_advance(&wheel, start + 9), 0);
+  ASSERT_EQ(timer_wheel_advance(&wheel, start + 10), 1);
+  ASSERT_EQ(log.size(), 1);
+}
+
+TEST(timer, start_long) {
+  timer_node_t slots[16];
+  timer_wheel_t wheel;
+  std::vector<std::pair<int, utils_tick_t>> log;
+  test_timer t = {{}, 1, &log, &wheel};
+  // the longest timeout, years of ns with the 64 bit host tick
+  utils_tick_t timeout = UTILS_TICK_MAX / 2 - 1;
+
+  timer_wheel_init(&wheel, slots, 16, 4, 100);
+  timer_init(&t.node, on_test_timer);
+  timer_start(&wheel, &t.node, timeout);
+  ASSERT_EQ(timer_wheel_advance(&wheel, 100 + timeout - 1), 0);
+  ASSERT_TRUE(timer_pending(&t.node));
+  ASSERT_EQ(timer_wheel_advance(&wheel, 100 + timeout), 1);
+  ASSERT_EQ(log.size(), 1);
+}
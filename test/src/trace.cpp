@@ -0,0 +1,91 @@
+/**
+ * @file trace.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+
+#include "trace_utils.h"
+#include "uart_sim.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+trace_span_stat_t span(uint16_t enter, uint16_t exit) {
+  trace_span_stat_t st = {};
+  st.enter = enter;
+  st.exit = exit;
+  return st;
+}
+} // namespace
+
+TEST(trace, order) {
+  std::vector<trace_record_t> ring(8), out(8);
+
+  // 11 records written, the 3 oldest are overwritten
+  for (uint32_t i = 0; i < 11; i++)
+    ring[i & 7] = {i * 10, trace_user, 0, i};
+  ASSERT_EQ(trace_order(ring.data(), 8, 11, out.data()), 8);
+  for (uint32_t i = 0; i < 8; i++)
+    ASSERT_EQ(out[i].arg, i + 3);
+  // not wrapped yet, starts at the first slot
+  ASSERT_EQ(trace_order(ring.data(), 8, 5, out.data()), 5);
+  ASSERT_EQ(out[0].arg, 8);
+  ASSERT_EQ(out[4].arg, 4);
+}
+
+TEST(trace, span_stats) {
+  std::vector<trace_record_t> rec = {
+      {100, trace_uart_isr_rx_enter, 1, 0},
+      {105, trace_uart_isr_tx_enter, 2, 0}, // other instance interleaves
+      {110, trace_uart_isr_rx_exit, 1, 0},
+      {125, trace_uart_isr_tx_exit, 2, 0},
+      {200, trace_uart_isr_rx_exit, 1, 0}, // no matching enter
+      {300, trace_uart_isr_rx_enter, 1, 0},
+      {330, trace_uart_isr_rx_exit, 1, 0},
+  };
+  trace_span_stat_t rx = span(trace_uart_isr_rx_enter, trace_uart_isr_rx_exit);
+  trace_span_stat_t tx = span(trace_uart_isr_tx_enter, trace_uart_isr_tx_exit);
+
+  trace_span_stats(rec.data(), rec.size(), &rx);
+  trace_span_stats(rec.data(), rec.size(), &tx);
+  ASSERT_EQ(rx.count, 2);
+  ASSERT_EQ(rx.min, 10);
+  ASSERT_EQ(rx.max, 30);
+  ASSERT_EQ(rx.total, 40);
+  ASSERT_EQ(tx.count, 1);
+  ASSERT_EQ(tx.min, 20);
+}
+
+#if UTILS_TRACE
+TEST(trace, uart_isr) {
+  char rx_buf[32], tx_buf[32];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  std::vector<trace_record_t> out(TRACE_RING_LEN);
+
+  sim.attach(&inst, &rx, &tx);
+  trace_ring.head = 0;
+  uart_enable_rx(&inst);
+  sim.feed("abc", 3);
+  sim.run();
+
+  size_t num = trace_order(trace_ring.records, trace_ring.len,
+                           trace_ring.head, out.data());
+  ASSERT_EQ(num, 6);
+  ASSERT_EQ(out[0].event, trace_uart_isr_rx_enter);
+  ASSERT_EQ(out[0].inst, TRACE_INST(&inst));
+  ASSERT_EQ(out[0].arg, 'a');
+  ASSERT_EQ(out[1].event, trace_uart_isr_rx_exit);
+
+  trace_span_stat_t st = span(trace_uart_isr_rx_enter, trace_uart_isr_rx_exit);
+  trace_span_stats(out.data(), num, &st);
+  ASSERT_EQ(st.count, 3);
+}
+#endif
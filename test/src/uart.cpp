@@ -9,9 +9,12 @@
  *
  */
 
+#include "uart_sim.h"
 #include "uart_utils.h"
 #include <gtest/gtest.h>
 #include <list>
+#include <string>
+#include <vector>
 namespace {
 extern "C" {
 
@@ -151,4 +154,368 @@ TEST(uart, write_when_read) {
   for (size_t i = 0; i < sizeof(tmp); i++) {
     ASSERT_EQ(tmp[i], msg[i]);
   }
-}
\ No newline at end of file
+}
+namespace {
+struct event_log_t {
+  std::vector<unsigned> events;
+  int wakes = 0;
+};
+
+void log_event(uart_t *, unsigned events, void *userdata) {
+  reinterpret_cast<event_log_t *>(userdata)->events.push_back(events);
+}
+
+void log_wake(uart_t *, void *userdata) {
+  reinterpret_cast<event_log_t *>(userdata)->wakes++;
+}
+} // namespace
+
+TEST(uart, event_rx_threshold) {
+  auto p = tear_up();
+  auto inst = p->inst;
+  event_log_t log;
+  uart_event_cfg_t cfg = {log_event, nullptr, &log,
+                          uart_event_rx_threshold, 0, 4};
+  char tmp[16];
+
+  uart_set_event_cfg(inst, &cfg);
+  for (int i = 0; i < 8; i++)
+    p->rx_buffer.push_back(i);
+  uart_enable_rx(inst);
+  ASSERT_EQ(log.events, std::vector<unsigned>{uart_event_rx_threshold});
+
+  // fires again only after the fifo dropped below the threshold
+  ASSERT_EQ(uart_read(inst, tmp, sizeof(tmp)), 8);
+  for (int i = 0; i < 3; i++)
+    p->rx_buffer.push_back(i);
+  try2rx(p);
+  ASSERT_EQ(log.events.size(), 1);
+  p->rx_buffer.push_back(0);
+  try2rx(p);
+  ASSERT_EQ(log.events.size(), 2);
+}
+
+TEST(uart, event_deferred) {
+  auto p = tear_up();
+  auto inst = p->inst;
+  event_log_t log;
+  uart_event_cfg_t cfg = {log_event,
+                          log_wake,
+                          &log,
+                          uart_event_rx_threshold | uart_event_tx_drained |
+                              uart_event_rx_overflow,
+                          uart_event_rx_threshold | uart_event_rx_overflow,
+                          1};
+  const char msg[] = "Hello,World";
+
+  uart_set_event_cfg(inst, &cfg);
+  uart_write(inst, msg, sizeof(msg));
+  ASSERT_EQ(log.events, std::vector<unsigned>{uart_event_tx_drained});
+
+  for (int i = 0; i < 200; i++)
+    p->rx_buffer.push_back(i);
+  uart_enable_rx(inst);
+  ASSERT_EQ(log.events.size(), 1);
+  ASSERT_EQ(log.wakes, 1);
+  ASSERT_EQ(uart_dispatch_events(inst),
+            uart_event_rx_threshold | uart_event_rx_overflow);
+  ASSERT_EQ(log.events.back(),
+            uart_event_rx_threshold | uart_event_rx_overflow);
+  ASSERT_EQ(uart_dispatch_events(inst), 0);
+  ASSERT_EQ(log.events.size(), 2);
+}
+
+TEST(uart, event_tx_space) {
+  auto p = tear_up();
+  auto inst = p->inst;
+  event_log_t log;
+  uart_event_cfg_t cfg = {log_event, nullptr, &log,
+                          uart_event_tx_space | uart_event_tx_drained, 0, 1};
+  char msg[128] = {};
+
+  uart_set_event_cfg(inst, &cfg);
+  // short writes never fill tx_fifo past half
+  uart_write(inst, msg, 16);
+  ASSERT_EQ(log.events, std::vector<unsigned>{uart_event_tx_drained});
+  size_t cap = fifo_capacity(inst->tx_fifo);
+  ASSERT_EQ(uart_write(inst, msg, cap), cap);
+  ASSERT_EQ(log.events,
+            (std::vector<unsigned>{uart_event_tx_drained, uart_event_tx_space,
+                                   uart_event_tx_drained}));
+}
+
+TEST(uart, write_reserve) {
+  auto p = tear_up();
+  auto inst = p->inst;
+  const char msg[] = "Hello,World";
+  char *buf;
+  std::string sent;
+
+  // move the fifo tail close to the end of its buffer
+  inst->tx_fifo->index_start = inst->tx_fifo->index_end = 120;
+  size_t len = uart_write_reserve(inst, &buf, sizeof(msg));
+  ASSERT_EQ(len, 8);
+  memcpy(buf, msg, len);
+  ASSERT_EQ(p->tx_buffer.size(), 0);
+  uart_write_commit(inst, len);
+  ASSERT_EQ(uart_write_reserve(inst, &buf, sizeof(msg) - len),
+            sizeof(msg) - len);
+  memcpy(buf, msg + len, sizeof(msg) - len);
+  uart_write_commit(inst, sizeof(msg) - len);
+
+  for (auto c : p->tx_buffer)
+    sent += c;
+  ASSERT_EQ(sent, std::string(msg, sizeof(msg)));
+}
+
+namespace {
+struct wait_ctx_t {
+  uart_sim *sim;
+  bool woken;
+  int waits;
+};
+wait_ctx_t wait_ctx;
+
+// one tick is one microsecond of simulated time
+uint32_t sim_wait(uart_t *, uint32_t timeout) {
+  uint64_t start = wait_ctx.sim->now();
+  uint64_t end = start + uint64_t(timeout) * 1000;
+  wait_ctx.waits++;
+  while (!wait_ctx.woken && wait_ctx.sim->now() < end)
+    wait_ctx.sim->run_until(wait_ctx.sim->now() + 1000);
+  wait_ctx.woken = false;
+  return (wait_ctx.sim->now() - start) / 1000;
+}
+
+void sim_wake(uart_t *) { wait_ctx.woken = true; }
+} // namespace
+
+TEST(uart, write_all) {
+  char rx_buf[32], tx_buf[32], msg[200];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+
+  for (size_t i = 0; i < sizeof(msg); i++)
+    msg[i] = i;
+  sim.attach(&inst, &rx, &tx);
+  wait_ctx = {&sim, false, 0};
+
+  // without hooks only what fits is written
+  ASSERT_EQ(uart_write_all(&inst, msg, sizeof(msg), UART_WAIT_FOREVER), 31);
+  sim.run();
+
+  uart_set_tx_wait(&inst, sim_wait, sim_wake);
+  ASSERT_EQ(uart_write_all(&inst, msg, sizeof(msg), UART_WAIT_FOREVER),
+            sizeof(msg));
+  // woken only when the fifo drained to half, not per byte
+  ASSERT_GT(wait_ctx.waits, 0);
+  ASSERT_LE(wait_ctx.waits, (sizeof(msg) - 31 + 14) / 15);
+  sim.run();
+  ASSERT_EQ(sim.tx_log().size(), 31 + sizeof(msg));
+  for (size_t i = 0; i < sizeof(msg); i++)
+    ASSERT_EQ(sim.tx_log()[31 + i].second, msg[i]);
+
+  // 10 bytes on the wire take ~868us at 115200 baud
+  size_t n = uart_write_all(&inst, msg, sizeof(msg), 1000);
+  ASSERT_GT(n, 31);
+  ASSERT_LT(n, sizeof(msg));
+}
+
+#if UART_TX_PRIO_LEVELS
+TEST(uart, write_prio) {
+  char rx_buf[16], tx_buf[256], bulk_buf[128], urgent_buf[32], msg[200];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  fifo_t bulk = {sizeof(bulk_buf), 1, 0, 0, bulk_buf};
+  fifo_t urgent = {sizeof(urgent_buf), 1, 0, 0, urgent_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  std::string wire;
+
+  memset(msg, '.', sizeof(msg));
+  sim.attach(&inst, &rx, &tx);
+  uart_set_tx_queue(&inst, 0, &bulk);
+  uart_set_tx_queue(&inst, 1, &urgent);
+
+  // plain writes are never split, a level cuts in after the one in flight
+  ASSERT_EQ(uart_write(&inst, msg, sizeof(msg)), sizeof(msg));
+  sim.run_until(10 * sim.byte_ns());
+  ASSERT_EQ(uart_write_prio(&inst, 1, "STOP", 4), 4);
+  ASSERT_EQ(uart_write(&inst, "plain", 5), 5);
+  sim.run();
+  for (auto &b : sim.tx_log())
+    wire += b.second;
+  ASSERT_EQ(wire, std::string(msg, sizeof(msg)) + "STOPplain");
+
+  // framed levels are only preempted at frame boundaries
+  wire.clear();
+  size_t base = sim.tx_log().size();
+  ASSERT_EQ(uart_write_prio(&inst, 0, std::string(20, 'a').data(), 20), 20);
+  ASSERT_EQ(uart_write_prio(&inst, 0, std::string(20, 'b').data(), 20), 20);
+  ASSERT_EQ(uart_write_prio(&inst, 0, std::string(20, 'c').data(), 20), 20);
+  sim.run_until(sim.now() + 5 * sim.byte_ns());
+  ASSERT_EQ(uart_write_prio(&inst, 1, "!!", 2), 2);
+  sim.run();
+  for (size_t i = base; i < sim.tx_log().size(); i++)
+    wire += sim.tx_log()[i].second;
+  ASSERT_EQ(wire, std::string(20, 'a') + "!!" + std::string(20, 'b') +
+                      std::string(20, 'c'));
+  ASSERT_EQ(fifo_len(&bulk), 0);
+
+  // all or nothing
+  ASSERT_EQ(uart_write_prio(&inst, 1, msg, 30), 0);
+  ASSERT_EQ(fifo_len(&urgent), 0);
+}
+#endif
+
+#if UART_UTILS_STATS
+TEST(uart, stats) {
+  char rx_buf[16], tx_buf[16], msg[40] = {0}, tmp[16];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  const uart_stats_t *st = uart_stats(&inst);
+
+  sim.attach(&inst, &rx, &tx);
+  uart_write(&inst, msg, 10);
+  sim.run();
+  ASSERT_EQ(st->bytes_tx, 10);
+  ASSERT_EQ(st->isr_tx, 10);
+  ASSERT_EQ(st->tx_restart, 1);
+
+  uart_enable_rx(&inst);
+  sim.feed(msg, 10);
+  sim.run();
+  ASSERT_EQ(uart_read(&inst, tmp, sizeof(tmp)), 10);
+  // 20 bytes into a 15 byte fifo, rx stops on overflow
+  sim.feed(msg, 20);
+  sim.run();
+  ASSERT_EQ(st->bytes_rx, 25);
+  ASSERT_EQ(st->isr_rx, 26);
+  ASSERT_EQ(st->rx_overflow, 1);
+  ASSERT_EQ(st->rx_abort, 1);
+  // one byte waits in the data register, the rest overruns
+  ASSERT_EQ(sim.stat().rx_overrun, 3);
+  ASSERT_EQ(uart_read(&inst, tmp, sizeof(tmp)), 15);
+  ASSERT_GT(st->rx_full_ticks, 0);
+
+  uint32_t samples = 0;
+  for (auto n : st->latency)
+    samples += n;
+  ASSERT_EQ(samples, 2);
+
+  uart_stats_reset(&inst);
+  ASSERT_EQ(st->bytes_rx, 0);
+}
+
+TEST(uart, stats_tx_full) {
+  char rx_buf[16], tx_buf[16], msg[16] = {0}, *buf;
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  const uart_stats_t *st = uart_stats(&inst);
+
+  sim.attach(&inst, &rx, &tx);
+  size_t len = uart_write_reserve(&inst, &buf, sizeof(msg));
+  ASSERT_EQ(len, fifo_capacity(&tx));
+  uart_write_commit(&inst, len);
+  ASSERT_TRUE(st->tx_full);
+  sim.run();
+  ASSERT_FALSE(st->tx_full);
+  ASSERT_GT(st->tx_full_ticks, 0);
+
+#if UART_TX_PRIO_LEVELS
+  char q_buf[16];
+  fifo_t q = {sizeof(q_buf), 1, 0, 0, q_buf};
+  uart_set_tx_queue(&inst, 0, &q);
+  uart_stats_reset(&inst);
+  // never fits, nothing to wait for
+  ASSERT_EQ(uart_write_prio(&inst, 0, msg, 14), 0);
+  ASSERT_FALSE(st->tx_full);
+  ASSERT_EQ(uart_write_prio(&inst, 0, msg, 8), 8);
+  ASSERT_EQ(uart_write_prio(&inst, 0, msg, 8), 0);
+  ASSERT_TRUE(st->tx_full);
+  sim.run();
+  ASSERT_FALSE(st->tx_full);
+  ASSERT_GT(st->tx_full_ticks, 0);
+#endif
+}
+#endif
+
+#if UART_RX_FILTER
+TEST(uart, rx_filter_start) {
+  char rx_buf[64], tx_buf[16], got[64];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim(uart_sim::config{});
+  uart_rx_filter_t filter;
+
+  // ':' len addr payload
+  uart_filter_init(&filter, uart_filter_start);
+  filter.start = ':';
+  filter.addr_offset = 2;
+  uart_filter_accept(&filter, 1, true);
+  uart_filter_accept(&filter, 0xff, true); // broadcast
+  sim.attach(&inst, &rx, &tx);
+  uart_set_rx_filter(&inst, &filter);
+  uart_enable_rx(&inst);
+
+  const char wire[] = "xx:\x03\x02"
+                      "abc:\x03\x01"
+                      "def:\x02\x05gh:\x01\xffi";
+  sim.feed(wire, sizeof(wire) - 1);
+  sim.run();
+  size_t n = uart_read(&inst, got, sizeof(got));
+  ASSERT_EQ(std::string(got, n), std::string(":\x03\x01"
+                                             "def:\x01\xffi",
+                                             10));
+}
+
+static char *filter_slot;
+extern "C" {
+static void filter_rx_async(char *ch, void *) { filter_slot = ch; }
+static void filter_abort(void *) {}
+static void filter_tx_async(const char *, void *) {}
+static void filter_mute(uart_t *, void *privdata) {
+  ++*static_cast<int *>(privdata);
+}
+}
+
+TEST(uart, rx_filter_addr_mark) {
+  char rx_buf[64], tx_buf[16], got[64];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  const uart_io_t io = {filter_rx_async, filter_abort, filter_tx_async,
+                        filter_abort};
+  uart_t inst;
+  uart_rx_filter_t filter;
+  int muted = 0;
+
+  uart_filter_init(&filter, uart_filter_addr_mark);
+  filter.mute = filter_mute;
+  uart_filter_accept(&filter, 7, true);
+  uart_init(&inst, &io, &muted, &rx, &tx);
+  uart_set_rx_filter(&inst, &filter);
+  uart_enable_rx(&inst);
+
+  // {byte, address mark}
+  const std::vector<std::pair<char, bool>> wire = {
+      {'z', false}, {'A', true},  {'x', false}, {7, true},   {'x', false},
+      {'y', false}, {2, true},    {'q', false}, {'q', false}, {7, true},
+      {'w', false}};
+  for (auto &b : wire) {
+    if (b.second)
+      uart_rx_addr_mark(&inst);
+    *filter_slot = b.first;
+    uart_isr_handle_rx(&inst);
+  }
+  size_t n = uart_read(&inst, got, sizeof(got));
+  ASSERT_EQ(std::string(got, n), "\x07xy\x07w");
+  ASSERT_EQ(muted, 2);
+}
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file uart_coro.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "uart_coro.h"
+
+#if defined(__linux__) && __cpp_impl_coroutine
+
+#include "pty_pair.h"
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// frame: 0xA5 len payload[len]
+extern "C" int match_coro(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if ((unsigned char)c != 0xA5)
+    return -1;
+  if (fifo_len(ptr) < 2)
+    return 0;
+  fifo_peek(ptr, 1, &c);
+  if (fifo_len(ptr) < (size_t)c + 2)
+    return 0;
+  return c + 2;
+}
+
+std::string frame(const std::string &payload) {
+  return std::string("\xA5") + char(payload.size()) + payload;
+}
+
+struct session {
+  pty_pair pty;
+  fifo_t rx, tx;
+  char rx_buf[32], tx_buf[16];
+  std::unique_ptr<utils::coro_port> port;
+  std::string wire, got;
+};
+
+utils::coro_task echo(utils::coro_port &port, int frames, int *done) {
+  char buf[64];
+  for (int i = 0; i < frames; i++) {
+    int n = co_await port.read_frame(match_coro, buf, sizeof(buf));
+    co_await port.write(buf, n);
+  }
+  (*done)++;
+}
+
+utils::coro_task read_some(utils::coro_port &port, std::string *got) {
+  char buf[16];
+  co_await port.readable();
+  got->append(buf, uart_read(port.uart(), buf, sizeof(buf)));
+}
+
+} // namespace
+
+TEST(uart_coro, readable) {
+  FIFO_DEFINE(rx, 32, char);
+  FIFO_DEFINE(tx, 32, char);
+  pty_pair pty;
+  utils::coro_loop loop;
+  std::string got;
+
+  ASSERT_TRUE(pty.ok());
+  ASSERT_TRUE(loop.ok());
+  utils::coro_port port(loop, pty.slave, FIFO_PTR(rx), FIFO_PTR(tx));
+  ASSERT_EQ(port.error(), 0);
+  read_some(port, &got);
+  ASSERT_GE(loop.run_once(0), 0);
+  ASSERT_TRUE(got.empty());
+  ASSERT_EQ(write(pty.master, "abc", 3), 3);
+  for (int i = 0; i < 100 && got.empty(); i++)
+    ASSERT_GE(loop.run_once(100), 0);
+  ASSERT_EQ(got, "abc");
+}
+
+TEST(uart_coro, echo_sessions) {
+  const int session_num = 64;
+  const int frame_num = 20;
+  utils::coro_loop loop;
+  std::vector<session> sessions(session_num);
+  int done = 0;
+
+  ASSERT_TRUE(loop.ok());
+  for (auto &s : sessions) {
+    ASSERT_TRUE(s.pty.ok());
+    s.rx = {sizeof(s.rx_buf), 1, 0, 0, s.rx_buf};
+    s.tx = {sizeof(s.tx_buf), 1, 0, 0, s.tx_buf};
+    s.port.reset(new utils::coro_port(loop, s.pty.slave, &s.rx, &s.tx));
+    ASSERT_EQ(s.port->error(), 0);
+    fcntl(s.pty.master, F_SETFL, fcntl(s.pty.master, F_GETFL) | O_NONBLOCK);
+    echo(*s.port, frame_num, &done);
+  }
+  // frames larger than tx_fifo make writers wait for tx space
+  for (int i = 0; i < session_num; i++) {
+    for (int j = 0; j < frame_num; j++)
+      sessions[i].wire += frame(std::string(j, char('a' + i % 26)));
+    ASSERT_EQ(write(sessions[i].pty.master, sessions[i].wire.data(),
+                    sessions[i].wire.size()),
+              sessions[i].wire.size());
+  }
+
+  size_t pending = session_num;
+  for (int i = 0; i < 10000 && pending; i++) {
+    ASSERT_GE(loop.run_once(10), 0);
+    pending = 0;
+    for (auto &s : sessions) {
+      char buf[256];
+      ssize_t n;
+      while ((n = read(s.pty.master, buf, sizeof(buf))) > 0)
+        s.got.append(buf, n);
+      pending += s.got.size() < s.wire.size();
+    }
+  }
+  ASSERT_EQ(done, session_num);
+  for (auto &s : sessions)
+    ASSERT_EQ(s.got, s.wire);
+}
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * @file uart_loop.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+
+#include "pty_pair.h"
+#include "uart_loop.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// frame: 0xA5 len payload[len]
+extern "C" int match_len(fifo_t *ptr) {
+  char c;
+  fifo_peek(ptr, 0, &c);
+  if ((unsigned char)c != 0xA5)
+    return -1;
+  if (fifo_len(ptr) < 2)
+    return 0;
+  fifo_peek(ptr, 1, &c);
+  if (fifo_len(ptr) < (size_t)c + 2)
+    return 0;
+  return c + 2;
+}
+
+void collect(uart_loop_port_t *, const char *frame, size_t len,
+             void *userdata) {
+  auto frames = reinterpret_cast<std::vector<std::string> *>(userdata);
+  frames->emplace_back(frame + 2, len - 2);
+}
+
+void echo(uart_loop_port_t *port, const char *frame, size_t len, void *) {
+  uart_write(&port->uart, frame, len);
+}
+
+void count_close(uart_loop_port_t *, void *userdata) {
+  ++*reinterpret_cast<int *>(userdata);
+}
+
+std::string frame(const std::string &payload) {
+  return std::string("\xA5") + char(payload.size()) + payload;
+}
+
+std::string read_all(int fd, size_t len) {
+  std::string s;
+  char buf[256];
+  while (s.size() < len) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0)
+      break;
+    s.append(buf, n);
+  }
+  return s;
+}
+
+} // namespace
+
+TEST(uart_loop, frames) {
+  FIFO_DEFINE(rx, 128, char);
+  FIFO_DEFINE(tx, 128, char);
+  pty_pair pty;
+  uart_loop_t loop;
+  uart_loop_port_t port;
+  char buf[64];
+  std::vector<std::string> frames;
+
+  ASSERT_TRUE(pty.ok());
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  ASSERT_EQ(uart_loop_add(&loop, &port, pty.slave, FIFO_PTR(rx), FIFO_PTR(tx)),
+            0);
+  uart_loop_set_matcher(&port, match_len, buf, sizeof(buf), collect, &frames);
+  uart_enable_rx(&port.uart);
+
+  std::string wire = "xx" + frame("Hello") + frame("World") + frame("");
+  ASSERT_EQ(write(pty.master, wire.data(), wire.size()), wire.size());
+  for (int i = 0; i < 100 && frames.size() < 3; i++)
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+  ASSERT_EQ(frames.size(), 3);
+
+  ASSERT_EQ(frames[0], "Hello");
+  ASSERT_EQ(frames[1], "World");
+  ASSERT_EQ(frames[2], "");
+  ASSERT_EQ(fifo_len(FIFO_PTR(rx)), 0);
+  uart_loop_deinit(&loop);
+}
+
+TEST(uart_loop, echo) {
+  FIFO_DEFINE(rx, 64, char);
+  FIFO_DEFINE(tx, 64, char);
+  pty_pair pty;
+  uart_loop_t loop;
+  uart_loop_port_t port;
+  char buf[64];
+  std::string wire;
+
+  ASSERT_TRUE(pty.ok());
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  ASSERT_EQ(uart_loop_add(&loop, &port, pty.slave, FIFO_PTR(rx), FIFO_PTR(tx)),
+            0);
+  uart_loop_set_matcher(&port, match_len, buf, sizeof(buf), echo, nullptr);
+  uart_enable_rx(&port.uart);
+
+  for (int i = 0; i < 100; i++)
+    wire += frame(std::to_string(i));
+  ASSERT_EQ(uart_loop_start(&loop), 0);
+  ASSERT_EQ(write(pty.master, wire.data(), wire.size()), wire.size());
+  ASSERT_EQ(read_all(pty.master, wire.size()), wire);
+  uart_loop_deinit(&loop);
+}
+
+TEST(uart_loop, backpressure) {
+  FIFO_DEFINE(rx, 16, char);
+  FIFO_DEFINE(tx, 16, char);
+  pty_pair pty;
+  uart_loop_t loop;
+  uart_loop_port_t port;
+  std::string wire, got;
+  char buf[16];
+
+  ASSERT_TRUE(pty.ok());
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  ASSERT_EQ(uart_loop_add(&loop, &port, pty.slave, FIFO_PTR(rx), FIFO_PTR(tx)),
+            0);
+  uart_enable_rx(&port.uart);
+
+  for (int i = 0; i < 64; i++)
+    wire += char('A' + i % 26);
+  ASSERT_EQ(write(pty.master, wire.data(), wire.size()), wire.size());
+
+  // data beyond fifo capacity must stay in the kernel, not get lost
+  while (got.size() < wire.size()) {
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+    size_t buffered = got.size() + fifo_len(FIFO_PTR(rx));
+    ASSERT_TRUE(fifo_full(FIFO_PTR(rx)) || buffered == wire.size());
+    size_t n = uart_read(&port.uart, buf, sizeof(buf));
+    got.append(buf, n);
+    uart_loop_update(&port);
+  }
+  ASSERT_EQ(got, wire);
+  ASSERT_EQ(uart_status(&port.uart), uart_status_rx);
+  uart_loop_deinit(&loop);
+}
+
+TEST(uart_loop, many_ports) {
+  const int port_num = 32;
+  uart_loop_t loop;
+  std::vector<pty_pair> ptys(port_num);
+  std::vector<uart_loop_port_t> ports(port_num);
+  std::vector<std::vector<char>> storage(port_num * 2,
+                                         std::vector<char>(64));
+  std::vector<fifo_t> fifos(port_num * 2);
+  std::vector<std::vector<std::string>> frames(port_num);
+  char buf[64];
+
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  for (int i = 0; i < port_num; i++) {
+    ASSERT_TRUE(ptys[i].ok());
+    for (int j = 0; j < 2; j++) {
+      fifo_t *fifo = &fifos[i * 2 + j];
+      fifo->fifo_len = 64;
+      fifo->type_len = 1;
+      fifo->index_start = fifo->index_end = 0;
+      fifo->buffer = storage[i * 2 + j].data();
+    }
+    ASSERT_EQ(uart_loop_add(&loop, &ports[i], ptys[i].slave, &fifos[i * 2],
+                            &fifos[i * 2 + 1]),
+              0);
+    uart_loop_set_matcher(&ports[i], match_len, buf, sizeof(buf), collect,
+                          &frames[i]);
+    uart_enable_rx(&ports[i].uart);
+  }
+
+  for (int i = 0; i < port_num; i++) {
+    std::string wire = frame(std::to_string(i)) + frame("end");
+    ASSERT_EQ(write(ptys[i].master, wire.data(), wire.size()), wire.size());
+  }
+  for (int i = 0; i < port_num; i++) {
+    for (int j = 0; j < 100 && frames[i].size() < 2; j++)
+      ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+    ASSERT_EQ(frames[i].size(), 2);
+    ASSERT_EQ(frames[i][0], std::to_string(i));
+    ASSERT_EQ(frames[i][1], "end");
+  }
+  uart_loop_deinit(&loop);
+}
+
+TEST(uart_loop, hangup) {
+  FIFO_DEFINE(rx, 128, char);
+  FIFO_DEFINE(tx, 128, char);
+  uart_loop_t loop;
+  uart_loop_port_t port;
+  char buf[64];
+  std::vector<std::string> frames;
+  int sv[2], closed = 0;
+
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  ASSERT_EQ(uart_loop_add(&loop, &port, sv[0], FIFO_PTR(rx), FIFO_PTR(tx)),
+            0);
+  uart_loop_set_matcher(&port, match_len, buf, sizeof(buf), collect, &frames);
+  uart_loop_set_close(&port, count_close, &closed);
+  uart_enable_rx(&port.uart);
+
+  std::string wire = frame("bye");
+  ASSERT_EQ(write(sv[1], wire.data(), wire.size()), wire.size());
+  close(sv[1]);
+  for (int i = 0; i < 100 && !closed; i++)
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+  // bytes sent before the hangup still arrive
+  ASSERT_EQ(frames, std::vector<std::string>{"bye"});
+  ASSERT_EQ(closed, 1);
+  ASSERT_TRUE(port.closed);
+
+  // the hung up fd no longer wakes the loop
+  for (int i = 0; i < 3; i++)
+    ASSERT_EQ(uart_loop_run_once(&loop, 10), 0);
+  ASSERT_EQ(closed, 1);
+  uart_loop_remove(&port);
+  close(sv[0]);
+  uart_loop_deinit(&loop);
+}
+
+#if UART_RX_FILTER
+TEST(uart_loop, rx_filter_held) {
+  FIFO_DEFINE(rx, 8, char);
+  FIFO_DEFINE(tx, 8, char);
+  uart_loop_t loop;
+  uart_loop_port_t port;
+  uart_rx_filter_t filter;
+  char buf[8];
+  std::string got;
+  int sv[2];
+
+  // 'S' x addr payload, only held bytes of the frame start are buffered
+  uart_filter_init(&filter, uart_filter_start);
+  filter.start = 'S';
+  filter.addr_offset = 2;
+  uart_filter_accept(&filter, 'A', true);
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  ASSERT_EQ(uart_loop_add(&loop, &port, sv[0], FIFO_PTR(rx), FIFO_PTR(tx)),
+            0);
+  uart_set_rx_filter(&port.uart, &filter);
+  uart_enable_rx(&port.uart);
+
+  ASSERT_EQ(write(sv[1], "SxAb", 4), 4);
+  for (int i = 0; i < 100 && fifo_len(FIFO_PTR(rx)) < 4; i++)
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+  ASSERT_EQ(write(sv[1], "Sx", 2), 2);
+  for (int i = 0; i < 100 && uart_rx_held(&port.uart) < 2; i++)
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+  // room for 3 more bytes, 2 of them are taken by the held header
+  ASSERT_EQ(write(sv[1], "Abcd", 4), 4);
+  for (int i = 0; i < 100 && !fifo_full(FIFO_PTR(rx)); i++)
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+  ASSERT_EQ(uart_loop_run_once(&loop, 10), 0);
+  ASSERT_EQ(uart_status(&port.uart), uart_status_rx);
+
+  while (got.size() < 10) {
+    size_t n = uart_read(&port.uart, buf, sizeof(buf));
+    got.append(buf, n);
+    uart_loop_update(&port);
+    ASSERT_GE(uart_loop_run_once(&loop, 100), 0);
+  }
+  ASSERT_EQ(got, "SxAbSxAbcd");
+  ASSERT_EQ(uart_status(&port.uart), uart_status_rx);
+  uart_loop_remove(&port);
+  close(sv[0]);
+  close(sv[1]);
+  uart_loop_deinit(&loop);
+}
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * @file uart_mp.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#ifdef __linux__
+
+#include "pty_pair.h"
+#include "uart_mp.h"
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int frame_size = 16;
+
+extern "C" {
+static void mock_rx_async(char *, void *) {}
+static void mock_rx_async_abort(void *) {}
+static void mock_tx_async(const char *, void *) {}
+static void mock_tx_async_abort(void *) {}
+}
+
+const uart_io_t mock_io = {mock_rx_async, mock_rx_async_abort, mock_tx_async,
+                           mock_tx_async_abort};
+
+void count_kick(uart_mp_t *mp) { (*reinterpret_cast<int *>(mp->userdata))++; }
+
+} // namespace
+
+TEST(uart_mp, all_or_nothing) {
+  FIFO_DEFINE(rx, 16, char);
+  FIFO_DEFINE(tx, 16, char);
+  uart_t uart;
+  uart_mp_t mp;
+  int kicks = 0;
+
+  uart_init(&uart, &mock_io, nullptr, FIFO_PTR(rx), FIFO_PTR(tx));
+  uart_mp_init(&mp, &uart, count_kick, &kicks);
+  ASSERT_EQ(uart_mp_write(&mp, "0123456789", 10), 10);
+  ASSERT_EQ(uart_mp_write(&mp, "abcdef", 6), 0);
+  ASSERT_EQ(fifo_len(FIFO_PTR(tx)), 10);
+  ASSERT_EQ(uart_mp_write(&mp, "abcde", 5), 5);
+  ASSERT_EQ(fifo_len(FIFO_PTR(tx)), 15);
+  // one kick until the backend serviced it
+  ASSERT_EQ(kicks, 1);
+
+  uart_mp_service(&mp);
+  ASSERT_EQ(uart_status(&uart), uart_status_tx);
+  while (uart_status(&uart) == uart_status_tx)
+    uart_isr_handle_tx(&uart);
+  // wraps around the end of tx_fifo
+  ASSERT_EQ(uart_mp_write(&mp, "0123456789", 10), 10);
+  ASSERT_EQ(kicks, 2);
+  char buf[10];
+  fifo_pop(FIFO_PTR(tx), buf, 10);
+  ASSERT_EQ(std::string(buf, 10), "0123456789");
+}
+
+TEST(uart_mp, no_interleave) {
+  const int writer_num = 4;
+  const int frame_num = 500;
+  FIFO_DEFINE(rx, 64, char);
+  FIFO_DEFINE(tx, 256, char);
+  pty_pair pty;
+  uart_loop_t loop;
+  uart_loop_port_t port;
+  uart_mp_t mp;
+  std::vector<std::thread> writers;
+
+  ASSERT_TRUE(pty.ok());
+  ASSERT_EQ(uart_loop_init(&loop), 0);
+  ASSERT_EQ(uart_loop_add(&loop, &port, pty.slave, FIFO_PTR(rx), FIFO_PTR(tx)),
+            0);
+  uart_mp_init_loop(&mp, &port);
+  ASSERT_EQ(uart_loop_start(&loop), 0);
+
+  for (int w = 0; w < writer_num; w++) {
+    writers.emplace_back([&mp, w] {
+      for (int i = 0; i < frame_num; i++) {
+        char frame[frame_size];
+        memset(frame, 'a' + w, sizeof(frame));
+        frame[1] = char(i & 0xff);
+        frame[2] = char(i >> 8);
+        while (!uart_mp_write(&mp, frame, sizeof(frame)))
+          sched_yield();
+      }
+    });
+  }
+
+  std::string wire;
+  char buf[256];
+  while (wire.size() < size_t(writer_num * frame_num * frame_size)) {
+    ssize_t n = read(pty.master, buf, sizeof(buf));
+    ASSERT_GT(n, 0);
+    wire.append(buf, n);
+  }
+  for (auto &t : writers)
+    t.join();
+  uart_loop_deinit(&loop);
+
+  std::vector<int> next(writer_num, 0);
+  for (size_t off = 0; off < wire.size(); off += frame_size) {
+    const char *frame = wire.data() + off;
+    int w = frame[0] - 'a';
+    ASSERT_GE(w, 0);
+    ASSERT_LT(w, writer_num);
+    int seq = (unsigned char)frame[1] | (unsigned char)frame[2] << 8;
+    ASSERT_EQ(seq, next[w]++);
+    for (int i = 3; i < frame_size; i++)
+      ASSERT_EQ(frame[i], frame[0]);
+  }
+}
+
+#endif
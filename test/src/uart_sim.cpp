@@ -0,0 +1,117 @@
+/**
+ * @file uart_sim.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+
+#include "uart_sim.h"
+#include <gtest/gtest.h>
+
+namespace {
+struct sim_port {
+  char rx_buf[128], tx_buf[128];
+  fifo_t rx = {sizeof(rx_buf), 1, 0, 0, rx_buf};
+  fifo_t tx = {sizeof(tx_buf), 1, 0, 0, tx_buf};
+  uart_t inst;
+  uart_sim sim;
+
+  explicit sim_port(const uart_sim::config &cfg) : sim(cfg) {
+    sim.attach(&inst, &rx, &tx);
+  }
+};
+} // namespace
+
+TEST(uart_sim, rx_timing) {
+  uart_sim::config cfg;
+  cfg.irq_latency_ns = 2000;
+  sim_port p(cfg);
+  const char msg[] = "Hello,World";
+  char tmp[sizeof(msg)];
+
+  uart_enable_rx(&p.inst);
+  p.sim.feed(msg, sizeof(msg));
+  p.sim.run();
+
+  ASSERT_EQ(p.sim.byte_ns(), 86805);
+  ASSERT_EQ(p.sim.now(), sizeof(msg) * p.sim.byte_ns() + 2000);
+  ASSERT_EQ(p.sim.max_rx_latency(), 2000);
+  ASSERT_EQ(uart_read(&p.inst, tmp, sizeof(tmp)), sizeof(msg));
+  ASSERT_EQ(memcmp(tmp, msg, sizeof(msg)), 0);
+}
+
+TEST(uart_sim, tx_timing) {
+  uart_sim::config cfg;
+  cfg.irq_latency_ns = 5000;
+  sim_port p(cfg);
+  const char msg[] = "0123456789";
+
+  uart_write(&p.inst, msg, 10);
+  p.sim.run();
+
+  auto &log = p.sim.tx_log();
+  ASSERT_EQ(log.size(), 10);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(log[i].second, msg[i]);
+    // every byte waits for the previous tx irq
+    ASSERT_EQ(log[i].first, (i + 1) * p.sim.byte_ns() + i * 5000);
+  }
+  ASSERT_EQ(uart_status(&p.inst), uart_status_idle);
+}
+
+TEST(uart_sim, overrun) {
+  uart_sim::config cfg;
+  cfg.irq_latency_ns = 100000; // slower than one byte time
+  sim_port slow(cfg);
+  cfg.hw_fifo_depth = 16;
+  sim_port deep(cfg);
+  char msg[16] = {0};
+
+  for (auto p : {&slow, &deep}) {
+    uart_enable_rx(&p->inst);
+    p->sim.feed(msg, sizeof(msg));
+    p->sim.run();
+  }
+  ASSERT_GT(slow.sim.stat().rx_overrun, 0);
+  ASSERT_EQ(slow.sim.stat().rx_isr + slow.sim.stat().rx_overrun, 16);
+  ASSERT_EQ(deep.sim.stat().rx_overrun, 0);
+  ASSERT_EQ(fifo_len(&deep.rx), 16);
+  ASSERT_GT(deep.sim.max_rx_latency(), cfg.irq_latency_ns);
+}
+
+TEST(uart_sim, error_injection) {
+  uart_sim::config cfg;
+  cfg.drop_rate = 0.1;
+  cfg.framing_error_rate = 0.1;
+  cfg.seed = 42;
+  sim_port a(cfg), b(cfg);
+  char msg[100], tmp[100];
+
+  for (int i = 0; i < 100; i++)
+    msg[i] = i;
+  for (auto p : {&a, &b}) {
+    uart_enable_rx(&p->inst);
+    p->sim.feed(msg, sizeof(msg));
+    p->sim.run();
+  }
+  auto &s = a.sim.stat();
+  ASSERT_GT(s.rx_dropped, 0);
+  ASSERT_GT(s.rx_framing, 0);
+  ASSERT_EQ(s.rx_isr, 100 - s.rx_dropped);
+  ASSERT_EQ(fifo_len(&a.rx), s.rx_isr);
+  // same seed, same faults
+  ASSERT_EQ(b.sim.stat().rx_dropped, s.rx_dropped);
+  ASSERT_EQ(b.sim.stat().rx_framing, s.rx_framing);
+  size_t n = uart_read(&a.inst, tmp, sizeof(tmp));
+  size_t corrupted = 0;
+  for (size_t i = 0, j = 0; i < n; i++) {
+    while (tmp[i] != msg[j] && char(tmp[i] ^ 0x80) != msg[j])
+      j++;
+    corrupted += tmp[i] != msg[j++];
+  }
+  ASSERT_EQ(corrupted, s.rx_framing);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file uart_static.cpp
+ * @author savent (savent_gate@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ */
+#include "uart_static.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+struct mock_io {
+  char *rx_ptr = nullptr;
+  const char *tx_ptr = nullptr;
+  std::string tx_log;
+  void rx_async(char *ch) { rx_ptr = ch; }
+  void rx_async_abort() { rx_ptr = nullptr; }
+  void tx_async(const char *ch) {
+    tx_ptr = ch;
+    tx_log += *ch;
+  }
+  void tx_async_abort() { tx_ptr = nullptr; }
+};
+
+using uart_type =
+    utils::Uart<mock_io, utils::StaticFifo<16>, utils::StaticFifo<16>>;
+
+void drain_tx(uart_type &uart) {
+  while (uart.status() == uart_status_tx)
+    uart.isr_tx();
+}
+
+void receive(uart_type &uart, const std::string &s) {
+  for (char c : s) {
+    ASSERT_NE(uart.io().rx_ptr, nullptr);
+    char *slot = uart.io().rx_ptr;
+    uart.io().rx_ptr = nullptr;
+    *slot = c;
+    uart.isr_rx();
+  }
+}
+
+} // namespace
+
+TEST(uart_static, fifo) {
+  utils::StaticFifo<8> fifo;
+  char buf[8];
+
+  ASSERT_EQ(fifo.capacity(), 7);
+  fifo.push("abcde", 5);
+  fifo.pop(buf, 4);
+  // wraps around the buffer end
+  fifo.push("fghijk", 6);
+  ASSERT_TRUE(fifo.full());
+  fifo.pop(buf, 7);
+  ASSERT_EQ(std::string(buf, 7), "efghijk");
+  ASSERT_EQ(fifo.len(), 0);
+}
+
+TEST(uart_static, write) {
+  uart_type uart;
+  const std::string msg = "Hello,World";
+
+  ASSERT_EQ(uart.write(msg.data(), msg.size()), msg.size());
+  ASSERT_EQ(uart.status(), uart_status_tx);
+  drain_tx(uart);
+  ASSERT_EQ(uart.io().tx_log, msg);
+  ASSERT_EQ(uart.status(), uart_status_idle);
+  // only what fits is accepted
+  ASSERT_EQ(uart.write(std::string(40, 'x').data(), 40), 15);
+}
+
+TEST(uart_static, read_write) {
+  uart_type uart;
+  char buf[16];
+
+  uart.enable_rx();
+  receive(uart, "ping");
+  ASSERT_EQ(uart.read(buf, sizeof(buf)), 4);
+  ASSERT_EQ(std::string(buf, 4), "ping");
+
+  // tx takes over and rx resumes once tx_fifo is empty
+  uart.write("pong", 4);
+  ASSERT_EQ(uart.io().rx_ptr, nullptr);
+  drain_tx(uart);
+  ASSERT_EQ(uart.io().tx_log, "pong");
+  ASSERT_EQ(uart.status(), uart_status_rx);
+  ASSERT_NE(uart.io().rx_ptr, nullptr);
+}
+
+TEST(uart_static, overflow) {
+  uart_type uart;
+  char buf[16];
+
+  uart.enable_rx();
+  receive(uart, std::string(15, 'a'));
+  // the 16th byte doesn't fit and stops rx
+  char *slot = uart.io().rx_ptr;
+  *slot = 'b';
+  uart.isr_rx();
+  ASSERT_EQ(uart.status(), uart_status_idle);
+  ASSERT_EQ(uart.io().rx_ptr, nullptr);
+  ASSERT_EQ(uart.read(buf, sizeof(buf)), 15);
+}
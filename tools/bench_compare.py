@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+@file bench_compare.py
+@author savent (savent_gate@outlook.com)
+@brief compare two google benchmark json outputs
+@version 0.1
+@date 2026-10-19
+
+Copyright 2026 savent_gate
+
+usage: bench_compare.py <baseline.json> <current.json> [--threshold 10]
+  Medians are used when the runs have repetitions. Exit code is 1 if a
+  benchmark present in both got more than threshold percent slower in cpu
+  time, 2 if the baseline is missing.
+"""
+import argparse
+import json
+import os
+import sys
+
+UNITS = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    runs = {}
+    for b in data["benchmarks"]:
+        if b.get("error_occurred"):
+            continue
+        aggregate = b.get("aggregate_name")
+        if aggregate not in (None, "median"):
+            continue
+        name = b.get("run_name", b["name"])
+        runs[name] = b["cpu_time"] * UNITS[b.get("time_unit", "ns")]
+    return data.get("context", {}), runs
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10)
+    args = parser.parse_args()
+
+    if not os.path.exists(args.baseline):
+        print("no baseline at %s, store one with the bench_baseline target"
+              % args.baseline)
+        return 2
+    base_ctx, base = load(args.baseline)
+    cur_ctx, cur = load(args.current)
+    for key in ("host_name", "num_cpus", "mhz_per_cpu"):
+        if base_ctx.get(key) != cur_ctx.get(key):
+            print("warning: %s differs, %s vs %s"
+                  % (key, base_ctx.get(key), cur_ctx.get(key)))
+
+    failed = []
+    width = max([len(n) for n in cur] + [9])
+    print("%-*s %12s %12s %8s" % (width, "benchmark", "base ns",
+                                  "current ns", "change"))
+    for name in sorted(cur):
+        if name not in base:
+            print("%-*s %12s %12.1f %8s" % (width, name, "-", cur[name],
+                                            "new"))
+            continue
+        change = (cur[name] - base[name]) / base[name] * 100
+        mark = ""
+        if change > args.threshold:
+            failed.append(name)
+            mark = " <-"
+        print("%-*s %12.1f %12.1f %+7.1f%%%s" % (width, name, base[name],
+                                                 cur[name], change, mark))
+    for name in sorted(set(base) - set(cur)):
+        print("%-*s %12.1f %12s %8s" % (width, name, base[name], "-",
+                                        "gone"))
+
+    if failed:
+        print("%d benchmark(s) slower than %.0f%%" % (len(failed),
+                                                      args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
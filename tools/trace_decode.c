@@ -0,0 +1,112 @@
+/**
+ * @file trace_decode.c
+ * @author savent (savent_gate@outlook.com)
+ * @brief print a trace_ring dump as timeline and span latency statistics
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Copyright 2026 savent_gate
+ *
+ * usage: trace_decode <dump> [-q]
+ *   dump  binary copy of trace_ring (len, head, records)
+ *   -q    statistics only, no timeline
+ */
+#include "trace_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *event_name(uint16_t event) {
+  switch (event) {
+  case trace_uart_isr_rx_enter:
+    return "uart_isr_rx_enter";
+  case trace_uart_isr_rx_exit:
+    return "uart_isr_rx_exit";
+  case trace_uart_isr_tx_enter:
+    return "uart_isr_tx_enter";
+  case trace_uart_isr_tx_exit:
+    return "uart_isr_tx_exit";
+  case trace_uart_rx_overflow:
+    return "uart_rx_overflow";
+  case trace_protocal_find_enter:
+    return "protocal_find_enter";
+  case trace_protocal_find_exit:
+    return "protocal_find_exit";
+  case trace_protocal_expire:
+    return "protocal_expire";
+  default:
+    return NULL;
+  }
+}
+
+int main(int argc, char **argv) {
+  static const struct {
+    const char *name;
+    uint16_t enter, exit;
+  } spans[] = {
+      {"uart_isr_rx", trace_uart_isr_rx_enter, trace_uart_isr_rx_exit},
+      {"uart_isr_tx", trace_uart_isr_tx_enter, trace_uart_isr_tx_exit},
+      {"protocal_find", trace_protocal_find_enter, trace_protocal_find_exit},
+  };
+  uint32_t hdr[2];
+  trace_record_t *records, *ordered;
+  size_t num;
+  FILE *fp;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <dump> [-q]\n", argv[0]);
+    return 1;
+  }
+  fp = fopen(argv[1], "rb");
+  if (!fp || fread(hdr, sizeof(hdr), 1, fp) != 1) {
+    fprintf(stderr, "can't read %s\n", argv[1]);
+    return 1;
+  }
+  if (!hdr[0] || (hdr[0] & (hdr[0] - 1))) {
+    fprintf(stderr, "bad ring length %u\n", hdr[0]);
+    return 1;
+  }
+  records = calloc(hdr[0], sizeof(*records));
+  ordered = calloc(hdr[0], sizeof(*ordered));
+  if (!records || !ordered ||
+      fread(records, sizeof(*records), hdr[0], fp) != hdr[0]) {
+    fprintf(stderr, "truncated dump\n");
+    return 1;
+  }
+  fclose(fp);
+
+  num = trace_order(records, hdr[0], hdr[1], ordered);
+  if (hdr[1] > hdr[0])
+    printf("# %u records lost to wrap around\n", hdr[1] - hdr[0]);
+
+  if (argc < 3 || strcmp(argv[2], "-q")) {
+    printf("%12s %10s %6s %-22s %s\n", "tick", "delta", "inst", "event",
+           "arg");
+    for (size_t i = 0; i < num; i++) {
+      const trace_record_t *r = &ordered[i];
+      const char *name = event_name(r->event);
+      uint32_t delta = i ? r->time - ordered[i - 1].time : 0;
+      if (name)
+        printf("%12u %10u %6u %-22s %u\n", r->time, delta, r->inst, name,
+               r->arg);
+      else if (r->event >= trace_user)
+        printf("%12u %10u %6u user+%-17u %u\n", r->time, delta, r->inst,
+               r->event - trace_user, r->arg);
+      else // built-in id unknown to this decoder
+        printf("%12u %10u %6u #%-21u %u\n", r->time, delta, r->inst,
+               r->event, r->arg);
+    }
+  }
+
+  printf("%-14s %8s %10s %10s %10s\n", "span", "count", "min", "avg", "max");
+  for (size_t i = 0; i < sizeof(spans) / sizeof(spans[0]); i++) {
+    trace_span_stat_t st = {.enter = spans[i].enter, .exit = spans[i].exit};
+    trace_span_stats(ordered, num, &st);
+    printf("%-14s %8u %10u %10llu %10u\n", spans[i].name, st.count, st.min,
+           st.count ? (unsigned long long)(st.total / st.count) : 0ull,
+           st.max);
+  }
+  free(records);
+  free(ordered);
+  return 0;
+}